@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <span>
+
+#include <cstddef>
+#include <cstdint>
+
+enum class AsyncReadBackend
+{
+    // io_uring where the kernel allows it, thread pool otherwise
+    AUTO,
+    IO_URING,
+    THREAD_POOL,
+};
+
+struct ReadRequest
+{
+    uint64_t offset;
+    size_t size;
+    std::byte *buffer;
+    // Returned as is in the completion
+    uint64_t user_data;
+};
+
+struct ReadCompletion
+{
+    uint64_t user_data;
+    // Less than requested size only at the end of file or on error
+    size_t size;
+    // errno value, 0 on success
+    int error;
+};
+
+/*
+ * Reads many independent ranges of a file with up to queue_depth reads in
+ * flight (POSIX only)
+ *
+ * io_uring keeps all queue_depth reads in the kernel queue, the thread
+ * pool backend runs one blocking read per worker thread and caps
+ * the workers, so at most 32 of its reads are in flight
+ *
+ * Requests are queued by submit() and started as slots free up, so any
+ * number of them can be submitted at once. Completions are returned in
+ * any order by poll() or drain() on the calling thread. Buffers must
+ * stay valid until their completion is returned
+ */
+struct AsyncFileReader
+{
+    static constexpr unsigned default_queue_depth = 64;
+
+    AsyncFileReader(
+        const char *name,
+        unsigned queue_depth = default_queue_depth,
+        AsyncReadBackend backend = AsyncReadBackend::AUTO);
+
+    AsyncFileReader(const AsyncFileReader &) = delete;
+    AsyncFileReader(AsyncFileReader &&) noexcept;
+    AsyncFileReader &operator=(const AsyncFileReader &) = delete;
+    AsyncFileReader &operator=(AsyncFileReader &&) noexcept;
+    ~AsyncFileReader();
+
+    void submit(std::span<const ReadRequest> requests);
+
+    /*
+     * Stores up to output.size() completions, waits until at least
+     * min_count (clipped at the number of pending requests) are ready
+     */
+    size_t poll(std::span<ReadCompletion> output, size_t min_count = 0);
+
+    // Waits for every pending request, calling callback(completion)
+    template <typename Callback>
+    size_t drain(Callback &&callback)
+    {
+        std::array<ReadCompletion, 64> completions;
+        size_t total = 0;
+        while (get_pending_count() > 0) {
+            size_t count = poll(completions, 1);
+            for (size_t i = 0; i < count; i++) {
+                callback(completions[i]);
+            }
+            total += count;
+        }
+        return total;
+    }
+
+    // Submitted requests whose completion was not returned yet
+    size_t get_pending_count() const;
+    AsyncReadBackend get_backend() const;
+    size_t file_size() const;
+
+  private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
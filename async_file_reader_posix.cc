@@ -0,0 +1,574 @@
+#include "async_file_reader.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <format>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+
+namespace {
+
+std::string errno_string(int status)
+{
+    return std::format("status {} ({})", status, strerror(status));
+}
+
+// Blocking read of the whole request, short only at the end of file
+ReadCompletion read_fully(int fd, const ReadRequest &request)
+{
+    size_t done = 0;
+    while (done < request.size) {
+        auto count = pread(
+            fd,
+            request.buffer + done,
+            request.size - done,
+            request.offset + done);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            return {request.user_data, done, errno};
+        }
+        if (count == 0) {
+            break;
+        }
+        done += count;
+    }
+    return {request.user_data, done, 0};
+}
+
+struct Reader
+{
+    Reader(int fd, size_t file_size, AsyncReadBackend backend)
+        : fd(fd), file_size(file_size), backend(backend)
+    {
+    }
+
+    Reader(const Reader &) = delete;
+    Reader &operator=(const Reader &) = delete;
+    virtual ~Reader()
+    {
+        close(fd);
+    }
+
+    virtual void submit(std::span<const ReadRequest> requests) = 0;
+    virtual size_t poll(std::span<ReadCompletion> output, size_t min_count) = 0;
+    virtual size_t get_pending_count() const = 0;
+
+    int fd;
+    size_t file_size;
+    AsyncReadBackend backend;
+};
+
+/*
+ * Every request is served by one blocking pread on a worker thread, up
+ * to queue_depth workers (at most max_thread_count)
+ */
+struct ThreadPoolReader final : Reader
+{
+    static constexpr unsigned max_thread_count = 32;
+
+    ThreadPoolReader(int fd, size_t file_size, unsigned queue_depth)
+        : Reader(fd, file_size, AsyncReadBackend::THREAD_POOL)
+    {
+        unsigned thread_count = std::clamp(queue_depth, 1u, max_thread_count);
+        try {
+            for (unsigned i = 0; i < thread_count; i++) {
+                m_threads.emplace_back([this] { work(); });
+            }
+        } catch (...) {
+            // Joinable threads must not outlive the constructor
+            stop();
+            throw;
+        }
+    }
+
+    ~ThreadPoolReader() override
+    {
+        stop();
+    }
+
+    void submit(std::span<const ReadRequest> requests) override
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_waiting.insert(
+                std::end(m_waiting), std::begin(requests), std::end(requests));
+            m_pending += requests.size();
+        }
+        m_work_cv.notify_all();
+    }
+
+    size_t poll(std::span<ReadCompletion> output, size_t min_count) override
+    {
+        std::unique_lock lock(m_mutex);
+        min_count = std::min({min_count, output.size(), m_pending});
+        m_done_cv.wait(lock, [&] { return m_completed.size() >= min_count; });
+
+        size_t count = std::min(output.size(), m_completed.size());
+        std::copy_n(std::begin(m_completed), count, std::begin(output));
+        m_completed.erase(
+            std::begin(m_completed), std::begin(m_completed) + count);
+        m_pending -= count;
+        return count;
+    }
+
+    size_t get_pending_count() const override
+    {
+        std::lock_guard lock(m_mutex);
+        return m_pending;
+    }
+
+  private:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_work_cv;
+    std::condition_variable m_done_cv;
+    std::deque<ReadRequest> m_waiting;
+    std::deque<ReadCompletion> m_completed;
+    size_t m_pending = 0;
+    bool m_stopping = false;
+    std::vector<std::thread> m_threads;
+
+    void stop()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+            m_waiting.clear();
+        }
+        m_work_cv.notify_all();
+        for (auto &thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    void work()
+    {
+        std::unique_lock lock(m_mutex);
+        while (true) {
+            m_work_cv.wait(
+                lock, [&] { return m_stopping || !m_waiting.empty(); });
+            if (m_stopping) {
+                return;
+            }
+
+            ReadRequest request = m_waiting.front();
+            m_waiting.pop_front();
+
+            lock.unlock();
+            auto completion = read_fully(fd, request);
+            lock.lock();
+
+            m_completed.push_back(completion);
+            m_done_cv.notify_one();
+        }
+    }
+};
+
+#ifdef __linux__
+
+/*
+ * io_uring through raw syscalls, one READV per request. Short reads are
+ * resubmitted for the rest of the range
+ */
+struct UringReader final : Reader
+{
+    // nullptr when io_uring is not available (old kernel, seccomp, sysctl)
+    static std::unique_ptr<UringReader>
+    create(int fd, size_t file_size, unsigned queue_depth)
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        int ring_fd = syscall(__NR_io_uring_setup, queue_depth, &params);
+        if (ring_fd < 0) {
+            return nullptr;
+        }
+
+        std::unique_ptr<UringReader> output(
+            new UringReader(fd, file_size, ring_fd, queue_depth));
+        if (!output->map_rings(params)) {
+            output->fd = -1;
+            return nullptr;
+        }
+        return output;
+    }
+
+    ~UringReader() override
+    {
+        // Buffers of reads in flight are written until they complete
+        m_waiting.clear();
+        while (m_in_flight > 0) {
+            int submitted = enter(m_to_submit, 1);
+            if (submitted < 0 && errno != EINTR) {
+                break;
+            }
+            m_to_submit -= std::max(submitted, 0);
+            reap({});
+        }
+
+        if (m_sqes) {
+            munmap(m_sqes, m_sqes_size);
+        }
+        if (m_cq_ring && m_cq_ring != m_sq_ring) {
+            munmap(m_cq_ring, m_cq_ring_size);
+        }
+        if (m_sq_ring) {
+            munmap(m_sq_ring, m_sq_ring_size);
+        }
+        close(m_ring_fd);
+    }
+
+    void submit(std::span<const ReadRequest> requests) override
+    {
+        m_waiting.insert(
+            std::end(m_waiting), std::begin(requests), std::end(requests));
+        m_pending += requests.size();
+
+        fill_queue();
+        submit_queued(0);
+    }
+
+    size_t poll(std::span<ReadCompletion> output, size_t min_count) override
+    {
+        if (output.empty()) {
+            return 0;
+        }
+        min_count = std::min({min_count, output.size(), m_pending});
+
+        size_t count = 0;
+        while (true) {
+            count += reap(output.subspan(count));
+            // Slots freed by reap are refilled before waiting on them
+            fill_queue();
+            bool is_done = count >= min_count || count == output.size();
+            submit_queued(is_done ? 0 : 1);
+            if (is_done) {
+                return count;
+            }
+        }
+    }
+
+    size_t get_pending_count() const override
+    {
+        return m_pending;
+    }
+
+  private:
+    struct Slot
+    {
+        ReadRequest request;
+        size_t done;
+        iovec io_vector;
+    };
+
+    int m_ring_fd;
+    unsigned m_queue_depth;
+
+    void *m_sq_ring = nullptr;
+    size_t m_sq_ring_size = 0;
+    void *m_cq_ring = nullptr;
+    size_t m_cq_ring_size = 0;
+    io_uring_sqe *m_sqes = nullptr;
+    size_t m_sqes_size = 0;
+
+    unsigned *m_sq_tail;
+    unsigned m_sq_mask;
+    unsigned *m_sq_array;
+    unsigned *m_cq_head;
+    unsigned *m_cq_tail;
+    unsigned m_cq_mask;
+    io_uring_cqe *m_cqes;
+
+    std::vector<Slot> m_slots;
+    std::vector<unsigned> m_free_slots;
+    std::deque<ReadRequest> m_waiting;
+    size_t m_pending = 0;
+    unsigned m_in_flight = 0;
+    unsigned m_to_submit = 0;
+
+    UringReader(int fd, size_t file_size, int ring_fd, unsigned queue_depth)
+        : Reader(fd, file_size, AsyncReadBackend::IO_URING),
+          m_ring_fd(ring_fd),
+          m_queue_depth(queue_depth)
+    {
+    }
+
+    bool map_rings(const io_uring_params &params)
+    {
+        m_sq_ring_size =
+            params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cq_ring_size =
+            params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool is_single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (is_single_mmap) {
+            m_sq_ring_size = m_cq_ring_size =
+                std::max(m_sq_ring_size, m_cq_ring_size);
+        }
+
+        void *sq_ring = mmap(
+            nullptr,
+            m_sq_ring_size,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE,
+            m_ring_fd,
+            IORING_OFF_SQ_RING);
+        if (sq_ring == MAP_FAILED) {
+            return false;
+        }
+        m_sq_ring = sq_ring;
+
+        void *cq_ring = sq_ring;
+        if (!is_single_mmap) {
+            cq_ring = mmap(
+                nullptr,
+                m_cq_ring_size,
+                PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE,
+                m_ring_fd,
+                IORING_OFF_CQ_RING);
+            if (cq_ring == MAP_FAILED) {
+                return false;
+            }
+        }
+        m_cq_ring = cq_ring;
+
+        m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        void *sqes = mmap(
+            nullptr,
+            m_sqes_size,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE,
+            m_ring_fd,
+            IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            return false;
+        }
+        m_sqes = static_cast<io_uring_sqe *>(sqes);
+
+        auto sq = static_cast<char *>(sq_ring);
+        m_sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        m_sq_mask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        m_sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+        auto cq = static_cast<char *>(cq_ring);
+        m_cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        m_cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        m_cq_mask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+        // Completion ring is twice the submission ring, it never overflows
+        m_queue_depth = std::min(m_queue_depth, params.sq_entries);
+        m_slots.resize(m_queue_depth);
+        for (unsigned i = m_queue_depth; i > 0; i--) {
+            m_free_slots.push_back(i - 1);
+        }
+        return true;
+    }
+
+    int enter(unsigned to_submit, unsigned min_complete)
+    {
+        unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+        return syscall(
+            __NR_io_uring_enter,
+            m_ring_fd,
+            to_submit,
+            min_complete,
+            flags,
+            nullptr,
+            0);
+    }
+
+    // Starts waiting requests while there are free slots
+    void fill_queue()
+    {
+        while (!m_waiting.empty() && !m_free_slots.empty()) {
+            unsigned slot_index = m_free_slots.back();
+            m_free_slots.pop_back();
+
+            m_slots[slot_index] = {m_waiting.front(), 0, {}};
+            m_waiting.pop_front();
+            m_in_flight++;
+            queue_read(slot_index);
+        }
+    }
+
+    void queue_read(unsigned slot_index)
+    {
+        Slot &slot = m_slots[slot_index];
+        slot.io_vector.iov_base = slot.request.buffer + slot.done;
+        slot.io_vector.iov_len = slot.request.size - slot.done;
+
+        // Submission entries are consumed by io_uring_enter, tail is ours
+        unsigned tail = *m_sq_tail;
+        unsigned index = tail & m_sq_mask;
+        io_uring_sqe &sqe = m_sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READV;
+        sqe.fd = fd;
+        sqe.off = slot.request.offset + slot.done;
+        sqe.addr = reinterpret_cast<uint64_t>(&slot.io_vector);
+        sqe.len = 1;
+        sqe.user_data = slot_index;
+        m_sq_array[index] = index;
+
+        std::atomic_ref(*m_sq_tail).store(tail + 1, std::memory_order_release);
+        m_to_submit++;
+    }
+
+    void submit_queued(unsigned min_complete)
+    {
+        while (m_to_submit > 0 || min_complete > 0) {
+            int submitted = enter(m_to_submit, min_complete);
+            if (submitted < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error(std::format(
+                    "io_uring_enter failue: {}", errno_string(errno)));
+            }
+            m_to_submit -= submitted;
+            min_complete = 0;
+        }
+    }
+
+    /*
+     * Moves completed requests to output, finished requests that do not
+     * fit are left in the ring. Empty output only drops completions
+     */
+    size_t reap(std::span<ReadCompletion> output)
+    {
+        bool is_dropping = output.empty();
+        size_t count = 0;
+
+        unsigned head = *m_cq_head;
+        unsigned tail =
+            std::atomic_ref(*m_cq_tail).load(std::memory_order_acquire);
+        while (head != tail && (is_dropping || count < output.size())) {
+            io_uring_cqe cqe = m_cqes[head & m_cq_mask];
+            head++;
+
+            unsigned slot_index = cqe.user_data;
+            Slot &slot = m_slots[slot_index];
+            bool is_retry = cqe.res == -EAGAIN || cqe.res == -EINTR;
+            if (cqe.res > 0) {
+                slot.done += cqe.res;
+            }
+            bool is_finished = cqe.res == 0 || slot.done == slot.request.size;
+            if (is_retry || (cqe.res > 0 && !is_finished)) {
+                queue_read(slot_index);
+                continue;
+            }
+
+            if (!is_dropping) {
+                int error = cqe.res < 0 ? -cqe.res : 0;
+                output[count++] = {slot.request.user_data, slot.done, error};
+            }
+            m_free_slots.push_back(slot_index);
+            m_in_flight--;
+            m_pending--;
+        }
+
+        std::atomic_ref(*m_cq_head).store(head, std::memory_order_release);
+        return count;
+    }
+};
+
+#endif
+
+} // namespace
+
+struct AsyncFileReader::Impl
+{
+    std::unique_ptr<Reader> reader;
+};
+
+AsyncFileReader::AsyncFileReader(
+    const char *name,
+    unsigned queue_depth,
+    AsyncReadBackend backend)
+{
+    queue_depth = std::max(queue_depth, 1u);
+
+    int fd = open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        throw std::invalid_argument(std::format(
+            "File \"{}\" open failue: {}", name, errno_string(errno)));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        auto status = errno;
+        close(fd);
+        throw std::invalid_argument(std::format(
+            "File \"{}\" stat failue: {}", name, errno_string(status)));
+    }
+
+    std::unique_ptr<Reader> reader;
+#ifdef __linux__
+    if (backend != AsyncReadBackend::THREAD_POOL) {
+        reader = UringReader::create(fd, st.st_size, queue_depth);
+    }
+#endif
+    if (!reader && backend == AsyncReadBackend::IO_URING) {
+        close(fd);
+        throw std::runtime_error(
+            std::format("io_uring is not available for file \"{}\"", name));
+    }
+    if (!reader) {
+        reader =
+            std::make_unique<ThreadPoolReader>(fd, st.st_size, queue_depth);
+    }
+    m_impl = std::make_unique<Impl>(std::move(reader));
+}
+
+AsyncFileReader::AsyncFileReader(AsyncFileReader &&) noexcept = default;
+AsyncFileReader &
+AsyncFileReader::operator=(AsyncFileReader &&) noexcept = default;
+AsyncFileReader::~AsyncFileReader() = default;
+
+void AsyncFileReader::submit(std::span<const ReadRequest> requests)
+{
+    m_impl->reader->submit(requests);
+}
+
+size_t AsyncFileReader::poll(std::span<ReadCompletion> output, size_t min_count)
+{
+    return m_impl->reader->poll(output, min_count);
+}
+
+size_t AsyncFileReader::get_pending_count() const
+{
+    return m_impl->reader->get_pending_count();
+}
+
+AsyncReadBackend AsyncFileReader::get_backend() const
+{
+    return m_impl->reader->backend;
+}
+
+size_t AsyncFileReader::file_size() const
+{
+    return m_impl->reader->file_size;
+}
@@ -8,14 +8,7 @@
 
 #include "libmedia/mpeg4.hh"
 
-template <size_t SIZE>
-consteval auto as_bytes(const uint8_t (&d)[SIZE])
-{
-    std::array<std::byte, SIZE> output{};
-    auto make_byte = [](uint8_t n) { return std::byte(n); };
-    std::ranges::copy(d | std::views::transform(make_byte), std::begin(output));
-    return output;
-}
+#include "box_test_util.hh"
 
 constexpr auto test_box_data =
     as_bytes({0, 0, 0, 12, 't', 'e', 's', 't', 1, 2, 3, 4});
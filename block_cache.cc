@@ -0,0 +1,195 @@
+#include "block_cache.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+struct BlockKey
+{
+    BlockCache::FileKey file;
+    uint64_t index;
+
+    bool operator==(const BlockKey &) const = default;
+};
+
+struct BlockKeyHash
+{
+    size_t operator()(const BlockKey &key) const
+    {
+        size_t output = 0;
+        for (uint64_t value :
+             {key.file.device,
+              key.file.inode,
+              static_cast<uint64_t>(key.file.mtime_ns),
+              key.index}) {
+            output ^= std::hash<uint64_t>{}(value) + 0x9e3779b97f4a7c15 +
+                (output << 6) + (output >> 2);
+        }
+        return output;
+    }
+};
+
+} // namespace
+
+struct BlockCache::Shard
+{
+    struct Slot
+    {
+        BlockKey key;
+        std::shared_ptr<const Block> block;
+        bool is_referenced = false;
+    };
+
+    explicit Shard(size_t capacity) : slots(capacity)
+    {
+        index.reserve(capacity);
+    }
+
+    std::shared_ptr<const Block> find(const BlockKey &key)
+    {
+        std::lock_guard lock(mutex);
+        auto found = index.find(key);
+        if (found == std::end(index)) {
+            misses++;
+            return nullptr;
+        }
+        hits++;
+        Slot &slot = slots[found->second];
+        slot.is_referenced = true;
+        return slot.block;
+    }
+
+    std::shared_ptr<const Block> insert(const BlockKey &key, Block block)
+    {
+        auto shared = std::make_shared<const Block>(std::move(block));
+
+        std::lock_guard lock(mutex);
+        auto found = index.find(key);
+        if (found != std::end(index)) {
+            Slot &slot = slots[found->second];
+            slot.is_referenced = true;
+            return slot.block;
+        }
+        // Budget smaller than one block, nothing is kept
+        if (slots.empty()) {
+            return shared;
+        }
+
+        size_t slot_index = find_victim();
+        Slot &slot = slots[slot_index];
+        if (slot.block) {
+            index.erase(slot.key);
+            resident_size -= slot.block->size();
+            evictions++;
+        }
+
+        slot = {key, shared, false};
+        index.emplace(key, slot_index);
+        resident_size += shared->size();
+        return shared;
+    }
+
+    // Referenced slots get a second chance, the first other one is taken
+    size_t find_victim()
+    {
+        while (true) {
+            Slot &slot = slots[hand];
+            size_t slot_index = hand;
+            hand = (hand + 1) % slots.size();
+            if (!slot.is_referenced) {
+                return slot_index;
+            }
+            slot.is_referenced = false;
+        }
+    }
+
+    mutable std::mutex mutex;
+    std::vector<Slot> slots;
+    std::unordered_map<BlockKey, size_t, BlockKeyHash> index;
+    size_t hand = 0;
+
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t resident_size = 0;
+};
+
+BlockCache::BlockCache(
+    size_t memory_budget,
+    size_t block_size,
+    unsigned shard_count)
+    : m_block_size(std::max<size_t>(block_size, 1))
+{
+    // Shards hold at least one block each (if any) and share the budget
+    size_t block_count = memory_budget / m_block_size;
+    shard_count = std::max<size_t>(
+        std::min<size_t>(shard_count, block_count), 1);
+    for (unsigned i = 0; i < shard_count; i++) {
+        size_t shard_capacity =
+            block_count / shard_count + (i < block_count % shard_count);
+        m_shards.push_back(std::make_unique<Shard>(shard_capacity));
+    }
+}
+
+BlockCache::~BlockCache() = default;
+
+BlockCache::Shard &BlockCache::get_shard(const FileKey &file, uint64_t index)
+{
+    size_t hash = BlockKeyHash{}({file, index});
+    return *m_shards[hash % m_shards.size()];
+}
+
+std::shared_ptr<const BlockCache::Block>
+BlockCache::find(const FileKey &file, uint64_t index)
+{
+    return get_shard(file, index).find({file, index});
+}
+
+std::shared_ptr<const BlockCache::Block>
+BlockCache::insert(const FileKey &file, uint64_t index, Block block)
+{
+    return get_shard(file, index).insert({file, index}, std::move(block));
+}
+
+BlockCache::Stats BlockCache::get_stats() const
+{
+    Stats output{0, 0, 0, 0};
+    for (auto &shard : m_shards) {
+        std::lock_guard lock(shard->mutex);
+        output.hits += shard->hits;
+        output.misses += shard->misses;
+        output.evictions += shard->evictions;
+        output.resident_size += shard->resident_size;
+    }
+    return output;
+}
+
+namespace {
+
+std::atomic<BlockCache *> global_cache = nullptr;
+std::mutex global_cache_mutex;
+
+} // namespace
+
+BlockCache *BlockCache::get_global()
+{
+    return global_cache.load(std::memory_order_acquire);
+}
+
+BlockCache &BlockCache::enable_global(size_t memory_budget, size_t block_size)
+{
+    std::lock_guard lock(global_cache_mutex);
+    if (auto cache = global_cache.load(std::memory_order_relaxed)) {
+        return *cache;
+    }
+
+    // Never destroyed, readers may still use it during static destruction
+    auto cache = new BlockCache(memory_budget, block_size);
+    global_cache.store(cache, std::memory_order_release);
+    return *cache;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Fixed size blocks of files shared by every reader of the process
+ *
+ * Blocks are keyed by file identity (device, inode, modification time)
+ * and block number, so readers of the same file share them and a
+ * rewritten file is not served stale data. Memory is bounded by the
+ * budget given at construction, blocks are evicted with CLOCK (second
+ * chance) per shard, every shard has its own lock
+ */
+struct BlockCache
+{
+    static constexpr size_t default_block_size = 64 * 1024;
+    static constexpr unsigned default_shard_count = 16;
+
+    struct FileKey
+    {
+        uint64_t device;
+        uint64_t inode;
+        int64_t mtime_ns;
+
+        bool operator==(const FileKey &) const = default;
+    };
+
+    // Shorter than block size only at the end of file
+    using Block = std::vector<std::byte>;
+
+    struct Stats
+    {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        size_t resident_size;
+    };
+
+    BlockCache(
+        size_t memory_budget,
+        size_t block_size = default_block_size,
+        unsigned shard_count = default_shard_count);
+
+    BlockCache(const BlockCache &) = delete;
+    BlockCache &operator=(const BlockCache &) = delete;
+    ~BlockCache();
+
+    // Returned blocks stay valid after eviction
+    std::shared_ptr<const Block> find(const FileKey &file, uint64_t index);
+
+    // Block already cached by another reader wins over the inserted one
+    std::shared_ptr<const Block>
+    insert(const FileKey &file, uint64_t index, Block block);
+
+    /*
+     * Cached block or the one read by load(offset, buffer, size), which
+     * returns the number of bytes read. load runs without any lock held
+     */
+    template <typename Load>
+    std::shared_ptr<const Block>
+    get(const FileKey &file, uint64_t index, Load &&load)
+    {
+        if (auto block = find(file, index)) {
+            return block;
+        }
+
+        Block block(m_block_size);
+        size_t size = load(index * m_block_size, block.data(), m_block_size);
+        block.resize(size);
+        return insert(file, index, std::move(block));
+    }
+
+    size_t block_size() const
+    {
+        return m_block_size;
+    }
+
+    Stats get_stats() const;
+
+    // Process wide cache, nullptr until enabled
+    static BlockCache *get_global();
+
+    /*
+     * Creates the process wide cache, later calls keep the first cache
+     * and return it
+     */
+    static BlockCache &enable_global(
+        size_t memory_budget,
+        size_t block_size = default_block_size);
+
+  private:
+    struct Shard;
+
+    size_t m_block_size;
+    std::vector<std::unique_ptr<Shard>> m_shards;
+
+    Shard &get_shard(const FileKey &file, uint64_t index);
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <ranges>
+#include <string_view>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+template <size_t SIZE>
+consteval auto as_bytes(const uint8_t (&d)[SIZE])
+{
+    std::array<std::byte, SIZE> output{};
+    auto make_byte = [](uint8_t n) { return std::byte(n); };
+    std::ranges::copy(d | std::views::transform(make_byte), std::begin(output));
+    return output;
+}
+
+/*
+ * Big endian payload of a test box, built during constant evaluation
+ * where boxes of many field combinations are needed
+ */
+struct TestPayload
+{
+    std::vector<std::byte> data;
+
+    constexpr TestPayload &u8(uint8_t value)
+    {
+        data.push_back(std::byte(value));
+        return *this;
+    }
+
+    constexpr TestPayload &u16(uint16_t value)
+    {
+        return u8(value >> 8).u8(value);
+    }
+
+    constexpr TestPayload &u32(uint32_t value)
+    {
+        return u16(value >> 16).u16(value);
+    }
+
+    constexpr TestPayload &u64(uint64_t value)
+    {
+        return u32(value >> 32).u32(value);
+    }
+};
+
+// Whole full box: 32 bit size, type, version, flags and payload
+constexpr std::vector<std::byte> make_full_box(
+    std::string_view type,
+    uint8_t version,
+    uint32_t flags,
+    const TestPayload &payload)
+{
+    TestPayload output;
+    output.u32(8 + 4 + payload.data.size());
+    for (char c : type) {
+        output.u8(c);
+    }
+    output.u8(version).u8(flags >> 16).u8(flags >> 8).u8(flags);
+    std::ranges::copy(payload.data, std::back_inserter(output.data));
+    return output.data;
+}
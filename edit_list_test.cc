@@ -0,0 +1,139 @@
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "libmedia/mpeg4/edit_list.hh"
+
+#include "box_test_util.hh"
+
+using Mpeg4::EditListBoxView;
+using Mpeg4::EditListTimeline;
+
+// Movie timescale 1000, media timescale 2000
+constexpr uint32_t movie_timescale = 1000;
+constexpr uint32_t media_timescale = 2000;
+
+constexpr auto test_elst_data = as_bytes({
+    0, 0, 0, 64, 'e', 'l', 's', 't', 0, 0, 0, 0, // header, version 0
+    0, 0, 0, 4,                                  // entry_count
+    // empty edit: movie [0, 1000)
+    0, 0, 0x03, 0xe8, 0xff, 0xff, 0xff, 0xff, 0, 1, 0, 0,
+    // movie [1000, 3000) plays media [500, 4500)
+    0, 0, 0x07, 0xd0, 0, 0, 0x01, 0xf4, 0, 1, 0, 0,
+    // dwell edit: movie [3000, 3500) holds media 3000
+    0, 0, 0x01, 0xf4, 0, 0, 0x0b, 0xb8, 0, 0, 0, 0,
+    // last edit of duration 0: media from 6000 to the end
+    0, 0, 0, 0, 0, 0, 0x17, 0x70, 0, 1, 0, 0,
+});
+constexpr EditListBoxView elst(Mpeg4::BoxView{test_elst_data});
+
+static_assert(elst.is_valid());
+static_assert(elst.get_entry_count() == 4);
+static_assert(elst.get_entry_unsafe(0).is_empty());
+static_assert(elst.get_entry_unsafe(0).segment_duration == 1000);
+static_assert(elst.get_entry_unsafe(1).media_time == 500);
+static_assert(elst.get_entry_unsafe(1).media_rate_integer == 1);
+static_assert(!elst.get_entry_unsafe(1).is_dwell());
+static_assert(elst.get_entry_unsafe(2).is_dwell());
+static_assert(elst.get_entry_unsafe(3).segment_duration == 0);
+static_assert(!elst.get_entry(4).has_value());
+
+constexpr auto test_elst_v1_data = as_bytes({
+    0, 0, 0, 36, 'e', 'l', 's', 't', 1, 0, 0, 0, // header, version 1
+    0, 0, 0, 1,                                  // entry_count
+    0, 0, 0, 1, 0, 0, 0, 0,                      // segment_duration
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, // media_time
+    0, 1, 0, 0,                                  // media_rate
+});
+constexpr EditListBoxView elst_v1(Mpeg4::BoxView{test_elst_v1_data});
+
+static_assert(elst_v1.is_valid());
+static_assert(elst_v1.get_entry_unsafe(0).segment_duration == 1ull << 32);
+static_assert(elst_v1.get_entry_unsafe(0).is_empty());
+
+// Truncated entries
+constexpr auto test_elst_short_data = as_bytes({
+    0, 0, 0, 20, 'e', 'l', 's', 't', 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1,
+});
+static_assert(!EditListBoxView(Mpeg4::BoxView{test_elst_short_data})
+                   .is_valid());
+
+consteval EditListTimeline make_timeline()
+{
+    return EditListTimeline::from_box(elst, movie_timescale, media_timescale)
+        .value();
+}
+
+consteval bool test_segments()
+{
+    auto timeline = make_timeline();
+    auto segments = timeline.get_segments();
+    return segments.size() == 4 && segments[0].empty &&
+        segments[1].movie_start == 1000 && segments[1].media_start == 500 &&
+        segments[1].media_duration == 4000 && segments[2].dwell &&
+        segments[2].media_duration == 0 && segments[3].movie_start == 3500 &&
+        segments[3].movie_duration == EditListTimeline::infinite &&
+        timeline.get_movie_duration() == EditListTimeline::infinite;
+}
+static_assert(test_segments());
+
+consteval std::optional<uint64_t> movie_to_media(uint64_t movie_time)
+{
+    return make_timeline().movie_to_media(movie_time);
+}
+
+static_assert(!movie_to_media(0).has_value());
+static_assert(!movie_to_media(999).has_value());
+static_assert(movie_to_media(1000) == 500);
+static_assert(movie_to_media(1500) == 1500);
+static_assert(movie_to_media(2999) == 4498);
+static_assert(movie_to_media(3000) == 3000);
+static_assert(movie_to_media(3499) == 3000);
+static_assert(movie_to_media(3500) == 6000);
+static_assert(movie_to_media(1'003'500) == 2'006'000);
+
+consteval std::optional<uint64_t> media_to_movie(uint64_t media_time)
+{
+    return make_timeline().media_to_movie(media_time);
+}
+
+static_assert(!media_to_movie(499).has_value());
+static_assert(media_to_movie(500) == 1000);
+// Played by the second edit before the dwell edit holds it
+static_assert(media_to_movie(3000) == 2250);
+static_assert(!media_to_movie(5000).has_value());
+static_assert(media_to_movie(6000) == 3500);
+static_assert(!media_to_movie(EditListTimeline::infinite).has_value());
+
+consteval bool test_map_movie_interval()
+{
+    auto pieces = make_timeline().map_movie_interval(0, 4000);
+    return pieces.size() == 3 && pieces[0].movie_begin == 1000 &&
+        pieces[0].movie_end == 3000 && pieces[0].media_begin == 500 &&
+        pieces[0].media_end == 4500 && pieces[1].movie_begin == 3000 &&
+        pieces[1].movie_end == 3500 && pieces[1].media_begin == 3000 &&
+        pieces[1].media_end == 3000 && pieces[2].movie_begin == 3500 &&
+        pieces[2].movie_end == 4000 && pieces[2].media_begin == 6000 &&
+        pieces[2].media_end == 7000;
+}
+static_assert(test_map_movie_interval());
+
+consteval bool test_map_media_interval()
+{
+    auto pieces = make_timeline().map_media_interval(2000, 7000);
+    return pieces.size() == 3 && pieces[0].movie_begin == 1750 &&
+        pieces[0].movie_end == 3000 && pieces[0].media_begin == 2000 &&
+        pieces[0].media_end == 4500 && pieces[1].movie_begin == 3000 &&
+        pieces[1].media_begin == 3000 && pieces[2].movie_begin == 3500 &&
+        pieces[2].movie_end == 4000 && pieces[2].media_end == 7000;
+}
+static_assert(test_map_media_interval());
+
+// Without edits times are only rescaled
+consteval bool test_no_edits()
+{
+    EditListTimeline timeline(movie_timescale, media_timescale);
+    return !timeline.has_edits() && timeline.movie_to_media(10) == 20 &&
+        timeline.media_to_movie(20) == 10;
+}
+static_assert(test_no_edits());
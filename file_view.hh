@@ -1,22 +1,102 @@
 #pragma once
 
+#include <functional>
+#include <span>
+#include <string_view>
+
 #include <cstddef>
 
+// Expected access pattern of a range of a view, hints only
+enum class FileAdvice
+{
+    NORMAL,
+    SEQUENTIAL,
+    RANDOM,
+    WILL_NEED,
+    DONT_NEED,
+};
+
+struct FileViewOptions
+{
+    // Applied to the whole view when it is opened
+    FileAdvice advice = FileAdvice::NORMAL;
+    // Read the whole view in while opening, so later access does not fault
+    bool populate = false;
+    // Back the view with huge pages where the system supports it
+    bool huge_pages = false;
+};
+
 struct alignas(8) FileView
 {
     FileView(const char *name);
+    FileView(const char *name, const FileViewOptions &options);
+
+    /*
+     * Maps only [offset, offset + size) of the file, size is clipped at
+     * the end of file. Mapping is page aligned internally, data() points
+     * exactly at offset
+     */
+    FileView(
+        const char *name,
+        size_t offset,
+        size_t size,
+        const FileViewOptions &options = {});
+
+    /*
+     * Views an open file descriptor, which stays owned by the caller.
+     * Regular files are mapped, pipes and sockets are read to their end
+     */
+    explicit FileView(int fd, const FileViewOptions &options = {});
+
+    // Borrows data, which must outlive the view
+    explicit FileView(std::span<const std::byte> data);
+
+    /*
+     * read(buffer, size) returns the number of bytes stored, 0 at the end
+     * of the stream
+     */
+    using StreamRead = std::function<size_t(std::byte *buffer, size_t size)>;
+
+    // Reads a forward only source to its end
+    explicit FileView(const StreamRead &read);
 
     FileView(const FileView &) = delete;
-    FileView(FileView &&) = delete;
+    // Moved from view is empty (no data, size 0)
+    FileView(FileView &&other) noexcept;
     FileView &operator=(const FileView &) = delete;
-    FileView &operator=(FileView &&) = delete;
+    FileView &operator=(FileView &&other) noexcept;
     ~FileView();
 
     const char *data();
     size_t size() const;
 
+    // Position of data() in the file
+    size_t offset() const;
+    size_t file_size() const;
+
+    /*
+     * Hints that [offset, offset + size) of the view will not be read
+     * again, so its memory can be dropped (it is read back from the file
+     * if touched)
+     */
+    void release(size_t offset, size_t size);
+
+    // Access pattern hint for [offset, offset + size) of the view
+    void advise(size_t offset, size_t size, FileAdvice advice);
+
   private:
     static constexpr size_t impl_size = 64;
     struct Impl;
     char impl[impl_size];
 };
+
+// Path "-" is standard input, as command line tools take it
+inline FileView
+open_file_view(const char *path, const FileViewOptions &options = {})
+{
+    constexpr int stdin_fd = 0;
+    if (std::string_view(path) == "-") {
+        return FileView(stdin_fd, options);
+    }
+    return FileView(path, options);
+}
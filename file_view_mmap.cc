@@ -1,5 +1,7 @@
 #include "file_view.hh"
+#include "file_view_posix.hh"
 
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
 #include <format>
@@ -7,6 +9,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <utility>
 
 #include <fcntl.h>
 #include <string>
@@ -33,7 +36,11 @@ struct FileView::Impl
         return true;
     }
 
-    Impl(const char *name)
+    Impl(
+        const char *name,
+        size_t offset,
+        size_t size,
+        const FileViewOptions &options)
     {
         int new_fd = open(name, O_RDONLY, 0);
         auto status = errno;
@@ -45,51 +52,72 @@ struct FileView::Impl
                 status,
                 status_string));
         }
-        fd = new_fd;
 
-        struct stat st;
-        if (fstat(new_fd, &st) != 0) {
-            auto status = errno;
-            std::string status_string = strerror(status);
-            close(fd);
-            throw std::invalid_argument(std::format(
-                "File \"{}\" stat failue: status {} ({})",
-                name,
-                status,
-                status_string));
+        try {
+            map_fd(new_fd, name, offset, size, options);
+        } catch (...) {
+            close(new_fd);
+            throw;
         }
+        fd = new_fd;
+    }
 
-        m_size = st.st_size;
+    Impl(int fd, const FileViewOptions &options)
+    {
+        std::string name = std::format("<fd {}>", fd);
 
-        void *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            throw_errno(name.c_str(), "stat");
+        }
 
-        if (data == MAP_FAILED) {
-            auto status = errno;
-            std::string status_string = strerror(status);
-            close(fd);
-            throw std::invalid_argument(std::format(
-                "File \"{}\" mmap failue: status {} ({})",
-                name,
-                status,
-                status_string));
+        // Only regular files can be mapped, the mapping outlives the fd
+        if (S_ISREG(st.st_mode)) {
+            map_fd(fd, name.c_str(), 0, SIZE_MAX, options);
+        } else {
+            take_stream(read_stream(make_fd_stream_read(fd)));
         }
+    }
+
+    Impl(std::span<const std::byte> data)
+        : file_data(reinterpret_cast<const uint8_t *>(data.data())),
+          m_size(data.size()),
+          m_file_size(data.size())
+    {
+    }
 
-        file_data = static_cast<uint8_t *>(data);
+    Impl(const FileView::StreamRead &read)
+    {
+        take_stream(read_stream(read));
     }
 
     Impl(const Impl &) = delete;
-    Impl(Impl &&) = delete;
+    Impl(Impl &&other) noexcept
+        : fd(std::exchange(other.fd, -1)),
+          is_file_mapped(std::exchange(other.is_file_mapped, false)),
+          map_size(std::exchange(other.map_size, 0)),
+          map_data(std::exchange(other.map_data, nullptr)),
+          file_data(std::exchange(other.file_data, nullptr)),
+          m_offset(std::exchange(other.m_offset, 0)),
+          m_size(std::exchange(other.m_size, 0)),
+          m_file_size(std::exchange(other.m_file_size, 0))
+    {
+    }
     Impl &operator=(const Impl &) = delete;
     Impl &operator=(Impl &&) = delete;
     ~Impl()
     {
-        munmap(file_data, m_size);
-        close(fd);
+        if (map_data) {
+            munmap(map_data, map_size);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
     }
 
     const char *data()
     {
-        return static_cast<const char *>(file_data);
+        return reinterpret_cast<const char *>(file_data);
     }
 
     size_t size() const
@@ -97,15 +125,209 @@ struct FileView::Impl
         return m_size;
     }
 
+    size_t offset() const
+    {
+        return m_offset;
+    }
+
+    size_t file_size() const
+    {
+        return m_file_size;
+    }
+
+    void release(size_t offset, size_t size)
+    {
+        if (!is_file_mapped || offset >= m_size) {
+            return;
+        }
+
+        // Only whole pages inside the range are dropped
+        uintptr_t page_size = sysconf(_SC_PAGESIZE);
+        uintptr_t begin = reinterpret_cast<uintptr_t>(file_data + offset);
+        uintptr_t end = reinterpret_cast<uintptr_t>(
+            file_data + offset + std::min(size, m_size - offset));
+        begin = (begin + page_size - 1) / page_size * page_size;
+        end = end / page_size * page_size;
+        if (begin >= end) {
+            return;
+        }
+
+        madvise(reinterpret_cast<void *>(begin), end - begin, MADV_DONTNEED);
+    }
+
+    void advise(size_t offset, size_t size, FileAdvice advice)
+    {
+        if (advice == FileAdvice::DONT_NEED) {
+            release(offset, size);
+            return;
+        }
+        if (!is_file_mapped || offset >= m_size) {
+            return;
+        }
+
+        int native_advice = MADV_NORMAL;
+        switch (advice) {
+        case FileAdvice::NORMAL:
+        case FileAdvice::DONT_NEED:
+            break;
+        case FileAdvice::SEQUENTIAL:
+            native_advice = MADV_SEQUENTIAL;
+            break;
+        case FileAdvice::RANDOM:
+            native_advice = MADV_RANDOM;
+            break;
+        case FileAdvice::WILL_NEED:
+            native_advice = MADV_WILLNEED;
+            break;
+        }
+
+        // Hint covers every page touching the range
+        uintptr_t page_size = sysconf(_SC_PAGESIZE);
+        uintptr_t begin = reinterpret_cast<uintptr_t>(file_data + offset);
+        uintptr_t end = reinterpret_cast<uintptr_t>(
+            file_data + offset + std::min(size, m_size - offset));
+        begin = begin / page_size * page_size;
+        madvise(reinterpret_cast<void *>(begin), end - begin, native_advice);
+    }
+
   private:
+    [[noreturn]] static void throw_errno(const char *name, const char *what)
+    {
+        auto status = errno;
+        std::string status_string = strerror(status);
+        throw std::invalid_argument(std::format(
+            "File \"{}\" {} failue: status {} ({})",
+            name,
+            what,
+            status,
+            status_string));
+    }
+
+    void map_fd(
+        int fd,
+        const char *name,
+        size_t offset,
+        size_t size,
+        const FileViewOptions &options)
+    {
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            throw_errno(name, "stat");
+        }
+
+        m_file_size = st.st_size;
+        if (offset > m_file_size) {
+            throw std::invalid_argument(std::format(
+                "File \"{}\" offset {} is past the end ({})",
+                name,
+                offset,
+                m_file_size));
+        }
+        m_offset = offset;
+        m_size = std::min(size, m_file_size - offset);
+        if (m_size == 0) {
+            return;
+        }
+
+        // mmap offset must be page aligned
+        size_t page_size = sysconf(_SC_PAGESIZE);
+        size_t map_offset = offset / page_size * page_size;
+        size_t new_map_size = m_size + (offset - map_offset);
+
+        int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+        if (options.populate) {
+            flags |= MAP_POPULATE;
+        }
+#endif
+
+        void *data =
+            mmap(nullptr, new_map_size, PROT_READ, flags, fd, map_offset);
+        if (data == MAP_FAILED) {
+            throw_errno(name, "mmap");
+        }
+
+        map_data = data;
+        map_size = new_map_size;
+        is_file_mapped = true;
+        file_data = static_cast<uint8_t *>(data) + (offset - map_offset);
+
+#ifdef MADV_HUGEPAGE
+        // Needs THP for page cache (read-only file THP), ignored otherwise
+        if (options.huge_pages) {
+            madvise(map_data, map_size, MADV_HUGEPAGE);
+        }
+#endif
+        if (options.advice != FileAdvice::NORMAL) {
+            advise(0, m_size, options.advice);
+        }
+    }
+
+    void take_stream(StreamBuffer buffer)
+    {
+        map_data = buffer.data;
+        map_size = buffer.capacity;
+        file_data = static_cast<const uint8_t *>(buffer.data);
+        m_size = m_file_size = buffer.size;
+    }
+
     int fd = -1;
+    // Stream buffers and borrowed data can not be read back from a file
+    bool is_file_mapped = false;
+    size_t map_size = 0;
+    void *map_data = nullptr;
+    const uint8_t *file_data = nullptr;
+    size_t m_offset = 0;
     size_t m_size = 0;
-    void *file_data = nullptr;
+    size_t m_file_size = 0;
 };
 
 FileView::FileView(const char *name)
+    : FileView(name, 0, SIZE_MAX)
+{
+}
+
+FileView::FileView(const char *name, const FileViewOptions &options)
+    : FileView(name, 0, SIZE_MAX, options)
+{
+}
+
+FileView::FileView(
+    const char *name,
+    size_t offset,
+    size_t size,
+    const FileViewOptions &options)
+{
+    new (impl) FileView::Impl(name, offset, size, options);
+}
+
+FileView::FileView(int fd, const FileViewOptions &options)
+{
+    new (impl) FileView::Impl(fd, options);
+}
+
+FileView::FileView(std::span<const std::byte> data)
+{
+    new (impl) FileView::Impl(data);
+}
+
+FileView::FileView(const StreamRead &read)
+{
+    new (impl) FileView::Impl(read);
+}
+
+FileView::FileView(FileView &&other) noexcept
+{
+    new (impl) FileView::Impl(std::move(Impl::cast(other)));
+}
+
+FileView &FileView::operator=(FileView &&other) noexcept
 {
-    new (impl) FileView::Impl(name);
+    if (this != &other) {
+        Impl::cast(*this).~Impl();
+        new (impl) FileView::Impl(std::move(Impl::cast(other)));
+    }
+    return *this;
 }
 
 const char *FileView::data()
@@ -118,8 +340,27 @@ size_t FileView::size() const
     return Impl::cast(*this).size();
 }
 
+size_t FileView::offset() const
+{
+    return Impl::cast(*this).offset();
+}
+
+size_t FileView::file_size() const
+{
+    return Impl::cast(*this).file_size();
+}
+
+void FileView::release(size_t offset, size_t size)
+{
+    Impl::cast(*this).release(offset, size);
+}
+
+void FileView::advise(size_t offset, size_t size, FileAdvice advice)
+{
+    Impl::cast(*this).advise(offset, size, advice);
+}
+
 FileView::~FileView()
 {
     Impl::cast(*this).~Impl();
 }
-
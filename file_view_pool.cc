@@ -0,0 +1,295 @@
+#include "file_view_pool.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct FileIdentity
+{
+    uint64_t device;
+    uint64_t inode;
+    int64_t mtime_ns;
+    uint64_t size;
+
+    bool operator==(const FileIdentity &) const = default;
+
+    static FileIdentity from_stat(const struct stat &st)
+    {
+        return {
+            static_cast<uint64_t>(st.st_dev),
+            static_cast<uint64_t>(st.st_ino),
+            st.st_mtim.tv_sec * 1'000'000'000LL + st.st_mtim.tv_nsec,
+            static_cast<uint64_t>(st.st_size)};
+    }
+};
+
+struct FileIdentityHash
+{
+    size_t operator()(const FileIdentity &identity) const
+    {
+        size_t output = 0;
+        for (uint64_t value :
+             {identity.device,
+              identity.inode,
+              static_cast<uint64_t>(identity.mtime_ns),
+              identity.size}) {
+            output ^= std::hash<uint64_t>{}(value) + 0x9e3779b97f4a7c15 +
+                (output << 6) + (output >> 2);
+        }
+        return output;
+    }
+};
+
+struct PathHash
+{
+    using is_transparent = void;
+
+    size_t operator()(std::string_view path) const
+    {
+        return std::hash<std::string_view>{}(path);
+    }
+};
+
+} // namespace
+
+struct FileViewPool::Impl
+{
+    struct Mapping
+    {
+        std::shared_ptr<FileView> view;
+        // Shared with callers, expires when the last of them releases it
+        std::weak_ptr<FileView> handle;
+        // Clock ticks of the last open or release
+        std::shared_ptr<std::atomic<Clock::rep>> last_used;
+
+        Clock::time_point get_last_used() const
+        {
+            return Clock::time_point(
+                Clock::duration(last_used->load(std::memory_order_relaxed)));
+        }
+
+        std::shared_ptr<FileView> acquire(Clock::time_point now)
+        {
+            last_used->store(
+                now.time_since_epoch().count(), std::memory_order_relaxed);
+            if (auto output = handle.lock()) {
+                return output;
+            }
+
+            // Release time is recorded without the pool, which may be gone
+            std::shared_ptr<FileView> output(
+                view.get(), [view = view, last_used = last_used](FileView *) {
+                    last_used->store(
+                        Clock::now().time_since_epoch().count(),
+                        std::memory_order_relaxed);
+                });
+            handle = output;
+            return output;
+        }
+    };
+
+    struct PathEntry
+    {
+        FileIdentity identity;
+        Clock::time_point validated;
+    };
+
+    FileViewPoolOptions options;
+
+    mutable std::mutex mutex;
+    std::unordered_map<FileIdentity, Mapping, FileIdentityHash> mappings;
+    std::unordered_map<std::string, PathEntry, PathHash, std::equal_to<>>
+        paths;
+    size_t mapped_size = 0;
+    Clock::time_point last_sweep = Clock::now();
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    // Mapping of path if it was validated recently, under lock
+    std::shared_ptr<FileView>
+    find_fresh(std::string_view path, Clock::time_point now)
+    {
+        auto path_entry = paths.find(path);
+        if (path_entry == std::end(paths) ||
+            now - path_entry->second.validated > options.revalidate_interval) {
+            return nullptr;
+        }
+        return use_mapping(path_entry->second.identity, now);
+    }
+
+    std::shared_ptr<FileView>
+    use_mapping(const FileIdentity &identity, Clock::time_point now)
+    {
+        auto mapping = mappings.find(identity);
+        if (mapping == std::end(mappings)) {
+            return nullptr;
+        }
+        hits++;
+        return mapping->second.acquire(now);
+    }
+
+    // Evicts when over size or when the last sweep is old, under lock
+    void sweep(Clock::time_point now)
+    {
+        auto sweep_interval = options.max_idle / 4;
+        if (mapped_size > options.max_mapped_size ||
+            now - last_sweep > sweep_interval) {
+            evict(now, options.max_mapped_size);
+        }
+    }
+
+    // Unmaps unused mappings, under lock
+    void evict(Clock::time_point now, size_t size_limit)
+    {
+        std::erase_if(mappings, [&](auto &item) {
+            const Mapping &mapping = item.second;
+            bool is_unused = mapping.handle.expired();
+            bool is_idle = now - mapping.get_last_used() > options.max_idle;
+            if (is_unused && is_idle) {
+                mapped_size -= mapping.view->size();
+                return true;
+            }
+            return false;
+        });
+
+        if (mapped_size > size_limit) {
+            std::vector<decltype(mappings)::iterator> unused;
+            for (auto item = std::begin(mappings); item != std::end(mappings);
+                 item++) {
+                if (item->second.handle.expired()) {
+                    unused.push_back(item);
+                }
+            }
+            std::ranges::sort(unused, {}, [](auto &item) {
+                return item->second.get_last_used();
+            });
+            for (auto &item : unused) {
+                if (mapped_size <= size_limit) {
+                    break;
+                }
+                mapped_size -= item->second.view->size();
+                mappings.erase(item);
+            }
+        }
+
+        // Paths of evicted mappings are stat()ed again on next open
+        std::erase_if(paths, [&](auto &item) {
+            return !mappings.contains(item.second.identity);
+        });
+        last_sweep = now;
+    }
+};
+
+FileViewPool::FileViewPool(const FileViewPoolOptions &options)
+    : m_impl(std::make_unique<Impl>())
+{
+    m_impl->options = options;
+}
+
+FileViewPool::~FileViewPool() = default;
+
+std::shared_ptr<FileView> FileViewPool::open(const char *path)
+{
+    Impl &impl = *m_impl;
+    auto now = Clock::now();
+
+    {
+        std::lock_guard lock(impl.mutex);
+        if (auto view = impl.find_fresh(path, now)) {
+            impl.sweep(now);
+            return view;
+        }
+    }
+
+    // stat, open and mmap run without the lock held
+    int fd = ::open(path, O_RDONLY, 0);
+    if (fd < 0) {
+        auto status = errno;
+        std::string status_string = strerror(status);
+        throw std::invalid_argument(std::format(
+            "File \"{}\" open failue: status {} ({})",
+            path,
+            status,
+            status_string));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        auto status = errno;
+        std::string status_string = strerror(status);
+        close(fd);
+        throw std::invalid_argument(std::format(
+            "File \"{}\" stat failue: status {} ({})",
+            path,
+            status,
+            status_string));
+    }
+    auto identity = FileIdentity::from_stat(st);
+
+    {
+        std::lock_guard lock(impl.mutex);
+        impl.paths.insert_or_assign(path, Impl::PathEntry{identity, now});
+        if (auto view = impl.use_mapping(identity, now)) {
+            close(fd);
+            return view;
+        }
+    }
+
+    std::shared_ptr<FileView> new_view;
+    try {
+        new_view =
+            std::make_shared<FileView>(fd, impl.options.view_options);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd);
+
+    std::lock_guard lock(impl.mutex);
+    impl.misses++;
+    // Another thread may have mapped the same file meanwhile
+    auto [mapping, is_new] = impl.mappings.try_emplace(
+        identity,
+        Impl::Mapping{
+            new_view, {}, std::make_shared<std::atomic<Clock::rep>>()});
+    if (is_new) {
+        impl.mapped_size += new_view->size();
+    }
+    auto view = mapping->second.acquire(now);
+    impl.sweep(now);
+    return view;
+}
+
+void FileViewPool::evict_idle()
+{
+    std::lock_guard lock(m_impl->mutex);
+    m_impl->evict(Clock::now(), m_impl->options.max_mapped_size);
+}
+
+FileViewPool::Stats FileViewPool::get_stats() const
+{
+    std::lock_guard lock(m_impl->mutex);
+    return {
+        m_impl->hits,
+        m_impl->misses,
+        m_impl->mappings.size(),
+        m_impl->mapped_size};
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "file_view.hh"
+
+struct FileViewPoolOptions
+{
+    // Unused mappings are unmapped this long after their last release
+    std::chrono::milliseconds max_idle = std::chrono::seconds(30);
+    // Unused mappings are unmapped, oldest first, above this total size
+    size_t max_mapped_size = size_t(16) * 1024 * 1024 * 1024;
+    /*
+     * A path is stat()ed again to notice a replaced or modified file at
+     * most this often, in between open() is a hash lookup
+     */
+    std::chrono::milliseconds revalidate_interval = std::chrono::seconds(1);
+    FileViewOptions view_options;
+};
+
+/*
+ * Shares one mapping between all opens of the same file (POSIX only)
+ *
+ * Mappings are keyed by file identity (device, inode, modification time,
+ * size), so hard links and symlinks share them and a changed file gets a
+ * new mapping. Views stay valid while referenced, even after the pool
+ * drops them. Thread safe
+ *
+ * Idle mappings are swept during open(), a pool that is no longer opened
+ * from keeps them mapped until evict_idle() is called
+ */
+struct FileViewPool
+{
+    struct Stats
+    {
+        uint64_t hits;
+        uint64_t misses;
+        size_t mapping_count;
+        size_t mapped_size;
+    };
+
+    FileViewPool(const FileViewPoolOptions &options = {});
+
+    FileViewPool(const FileViewPool &) = delete;
+    FileViewPool &operator=(const FileViewPool &) = delete;
+    ~FileViewPool();
+
+    std::shared_ptr<FileView> open(const char *path);
+
+    // Unmaps unused mappings idle for longer than max_idle
+    void evict_idle();
+
+    Stats get_stats() const;
+
+  private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
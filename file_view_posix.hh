@@ -0,0 +1,123 @@
+#pragma once
+
+/*
+ * Helpers shared by the POSIX FileView backends (mmap, pread) for views
+ * of non seekable sources
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <string>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "file_view.hh"
+
+// Private anonymous memory holding a whole stream, released with munmap
+struct StreamBuffer
+{
+    void *data = nullptr;
+    size_t capacity = 0;
+    size_t size = 0;
+};
+
+[[noreturn]] inline void throw_stream_errno(const char *what)
+{
+    auto status = errno;
+    std::string status_string = strerror(status);
+    throw std::invalid_argument(std::format(
+        "Stream {} failue: status {} ({})", what, status, status_string));
+}
+
+/*
+ * Reads to the end of stream, memory grows by doubling (in place with
+ * mremap where available)
+ */
+inline StreamBuffer read_stream(const FileView::StreamRead &read)
+{
+    constexpr size_t initial_capacity = 1024 * 1024;
+
+    StreamBuffer output;
+    try {
+        while (true) {
+            if (output.size == output.capacity) {
+                size_t capacity =
+                    std::max(output.capacity * 2, initial_capacity);
+#ifdef MREMAP_MAYMOVE
+                void *data = output.data
+                    ? mremap(
+                          output.data,
+                          output.capacity,
+                          capacity,
+                          MREMAP_MAYMOVE)
+                    : mmap(
+                          nullptr,
+                          capacity,
+                          PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS,
+                          -1,
+                          0);
+#else
+                void *data = mmap(
+                    nullptr,
+                    capacity,
+                    PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS,
+                    -1,
+                    0);
+                if (data != MAP_FAILED && output.data) {
+                    std::memcpy(data, output.data, output.size);
+                    munmap(output.data, output.capacity);
+                }
+#endif
+                if (data == MAP_FAILED) {
+                    throw_stream_errno("buffer mmap");
+                }
+                output.data = data;
+                output.capacity = capacity;
+            }
+
+            size_t count = read(
+                static_cast<std::byte *>(output.data) + output.size,
+                output.capacity - output.size);
+            if (count == 0) {
+                break;
+            }
+            output.size += count;
+        }
+    } catch (...) {
+        if (output.data) {
+            munmap(output.data, output.capacity);
+        }
+        throw;
+    }
+
+    if (output.size == 0 && output.data) {
+        munmap(output.data, output.capacity);
+        output = {};
+    }
+    return output;
+}
+
+// Stream reading from fd with read(2)
+inline FileView::StreamRead make_fd_stream_read(int fd)
+{
+    return [fd](std::byte *buffer, size_t size) -> size_t {
+        while (true) {
+            auto count = ::read(fd, buffer, size);
+            if (count >= 0) {
+                return count;
+            }
+            if (errno != EINTR) {
+                throw_stream_errno("read");
+            }
+        }
+    };
+}
@@ -0,0 +1,496 @@
+#include "file_view.hh"
+
+#include "block_cache.hh"
+#include "file_view_posix.hh"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Metadata only backend for filesystems where page faults are slow
+ * round trips (NFS, FUSE)
+ *
+ * The file is not mapped. Top level boxes are walked with pread and
+ * copied into an anonymous zero filled mapping at their file offsets,
+ * payloads of mdat, free and skip boxes are not read and stay zero.
+ * Small reads go through a few cached blocks, so headers of neighbouring
+ * boxes are fetched with one read. When the process wide BlockCache is
+ * enabled every read goes through it instead, so metadata of files
+ * opened again is served from memory
+ */
+namespace {
+
+[[noreturn]] void throw_errno(const char *name, const char *what)
+{
+    auto status = errno;
+    std::string status_string = strerror(status);
+    throw std::invalid_argument(std::format(
+        "File \"{}\" {} failue: status {} ({})",
+        name,
+        what,
+        status,
+        status_string));
+}
+
+struct BlockReader
+{
+    static constexpr size_t block_size = 4 * 1024;
+    static constexpr size_t block_count = 8;
+
+    BlockReader(int fd, const char *name, const struct stat &st)
+        : m_fd(fd),
+          m_name(name),
+          m_file_size(st.st_size),
+          m_cache(BlockCache::get_global()),
+          m_file_key{
+              static_cast<uint64_t>(st.st_dev),
+              static_cast<uint64_t>(st.st_ino),
+              st.st_mtim.tv_sec * 1'000'000'000LL + st.st_mtim.tv_nsec}
+    {
+    }
+
+    // Reads [offset, offset + size) clipped at the end of file
+    size_t read(uint64_t offset, size_t size, char *output)
+    {
+        if (offset >= m_file_size) {
+            return 0;
+        }
+        size = std::min<uint64_t>(size, m_file_size - offset);
+
+        if (m_cache) {
+            read_cached(offset, size, output);
+            return size;
+        }
+
+        // Large ranges are read at once, no point to cache them
+        if (size >= block_size) {
+            read_exact(offset, size, output);
+            return size;
+        }
+
+        size_t done = 0;
+        while (done < size) {
+            uint64_t position = offset + done;
+            auto &block = get_block(position / block_size);
+            size_t block_offset = position - block.offset;
+            size_t count = std::min(size - done, block.size - block_offset);
+            std::memcpy(output + done, block.data.data() + block_offset, count);
+            done += count;
+        }
+        return size;
+    }
+
+  private:
+    struct Block
+    {
+        uint64_t offset = UINT64_MAX;
+        size_t size = 0;
+        uint64_t last_use = 0;
+        std::vector<char> data;
+    };
+
+    int m_fd;
+    const char *m_name;
+    uint64_t m_file_size;
+    BlockCache *m_cache;
+    BlockCache::FileKey m_file_key;
+    uint64_t m_use_counter = 0;
+    std::array<Block, block_count> m_blocks;
+
+    Block &get_block(uint64_t index)
+    {
+        uint64_t offset = index * block_size;
+        m_use_counter++;
+
+        auto block = std::ranges::find(m_blocks, offset, &Block::offset);
+        if (block == std::end(m_blocks)) {
+            block = std::ranges::min_element(m_blocks, {}, &Block::last_use);
+            block->offset = offset;
+            block->size = std::min<uint64_t>(block_size, m_file_size - offset);
+            block->data.resize(block_size);
+            read_exact(offset, block->size, block->data.data());
+        }
+        block->last_use = m_use_counter;
+        return *block;
+    }
+
+    void read_cached(uint64_t offset, size_t size, char *output)
+    {
+        auto load = [this](uint64_t offset, std::byte *buffer, size_t size) {
+            size = std::min<uint64_t>(size, m_file_size - offset);
+            read_exact(offset, size, reinterpret_cast<char *>(buffer));
+            return size;
+        };
+
+        size_t cache_block_size = m_cache->block_size();
+        size_t done = 0;
+        while (done < size) {
+            uint64_t position = offset + done;
+            uint64_t index = position / cache_block_size;
+            auto block = m_cache->get(m_file_key, index, load);
+
+            size_t block_offset = position - index * cache_block_size;
+            if (block_offset >= block->size()) {
+                // Cached before the file grew, should not happen with mtime
+                throw std::invalid_argument(
+                    std::format("File \"{}\" changed while reading", m_name));
+            }
+            size_t count = std::min(size - done, block->size() - block_offset);
+            std::memcpy(output + done, block->data() + block_offset, count);
+            done += count;
+        }
+    }
+
+    void read_exact(uint64_t offset, size_t size, char *output)
+    {
+        while (size > 0) {
+            auto count = pread(m_fd, output, size, offset);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count < 0) {
+                throw_errno(m_name, "read");
+            }
+            if (count == 0) {
+                throw std::invalid_argument(
+                    std::format("File \"{}\" truncated while reading", m_name));
+            }
+            output += count;
+            offset += count;
+            size -= count;
+        }
+    }
+};
+
+uint32_t read_be32(const char *data)
+{
+    auto bytes = reinterpret_cast<const uint8_t *>(data);
+    return uint32_t(bytes[0]) << 24 | uint32_t(bytes[1]) << 16 |
+        uint32_t(bytes[2]) << 8 | uint32_t(bytes[3]);
+}
+
+bool is_payload_skipped(const char *type)
+{
+    constexpr std::array<std::string_view, 3> skipped_types{
+        "mdat", "free", "skip"};
+    return std::ranges::find(skipped_types, std::string_view(type, 4)) !=
+        std::end(skipped_types);
+}
+
+} // namespace
+
+struct FileView::Impl
+{
+    static FileView::Impl &cast(FileView &f)
+    {
+        return *reinterpret_cast<FileView::Impl *>(f.impl);
+    }
+
+    static const FileView::Impl &cast(const FileView &f)
+    {
+        return *reinterpret_cast<const FileView::Impl *>(f.impl);
+    }
+
+    static bool assert_impl()
+    {
+        static_assert(sizeof(FileView::Impl) <= FileView::impl_size);
+        static_assert(alignof(FileView) >= alignof(FileView::Impl));
+        return true;
+    }
+
+    Impl(const char *name, size_t offset, size_t size)
+    {
+        int fd = open(name, O_RDONLY, 0);
+        if (fd < 0) {
+            throw_errno(name, "open");
+        }
+
+        try {
+            load_fd(fd, name, offset, size);
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+        close(fd);
+    }
+
+    Impl(int fd)
+    {
+        std::string name = std::format("<fd {}>", fd);
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            throw_errno(name.c_str(), "stat");
+        }
+
+        if (S_ISREG(st.st_mode)) {
+            load_fd(fd, name.c_str(), 0, SIZE_MAX);
+        } else {
+            take_stream(read_stream(make_fd_stream_read(fd)));
+        }
+    }
+
+    Impl(std::span<const std::byte> data)
+        : m_data(reinterpret_cast<const char *>(data.data())),
+          m_size(data.size()),
+          m_file_size(data.size())
+    {
+    }
+
+    Impl(const FileView::StreamRead &read)
+    {
+        take_stream(read_stream(read));
+    }
+
+    Impl(const Impl &) = delete;
+    Impl(Impl &&other) noexcept
+        : m_map_data(std::exchange(other.m_map_data, nullptr)),
+          m_map_size(std::exchange(other.m_map_size, 0)),
+          m_data(std::exchange(other.m_data, nullptr)),
+          m_offset(std::exchange(other.m_offset, 0)),
+          m_size(std::exchange(other.m_size, 0)),
+          m_file_size(std::exchange(other.m_file_size, 0))
+    {
+    }
+    Impl &operator=(const Impl &) = delete;
+    Impl &operator=(Impl &&) = delete;
+    ~Impl()
+    {
+        if (m_map_data) {
+            munmap(m_map_data, m_map_size);
+        }
+    }
+
+    const char *data()
+    {
+        return m_data;
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    size_t offset() const
+    {
+        return m_offset;
+    }
+
+    size_t file_size() const
+    {
+        return m_file_size;
+    }
+
+  private:
+    // Owned memory, none for borrowed data
+    void *m_map_data = nullptr;
+    size_t m_map_size = 0;
+    const char *m_data = nullptr;
+    size_t m_offset = 0;
+    size_t m_size = 0;
+    size_t m_file_size = 0;
+
+    void load_fd(int fd, const char *name, size_t offset, size_t size)
+    {
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            throw_errno(name, "stat");
+        }
+
+        m_file_size = st.st_size;
+        if (offset > m_file_size) {
+            throw std::invalid_argument(std::format(
+                "File \"{}\" offset {} is past the end ({})",
+                name,
+                offset,
+                m_file_size));
+        }
+        m_offset = offset;
+        m_size = std::min(size, m_file_size - offset);
+        if (m_size == 0) {
+            return;
+        }
+
+        // Pages that are never written are never allocated
+        void *data = mmap(
+            nullptr,
+            m_size,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+            -1,
+            0);
+        if (data == MAP_FAILED) {
+            throw_errno(name, "buffer mmap");
+        }
+        m_map_data = data;
+        m_map_size = m_size;
+        m_data = static_cast<const char *>(data);
+
+        BlockReader reader(fd, name, st);
+        load_metadata(reader);
+        mprotect(m_map_data, m_map_size, PROT_READ);
+    }
+
+    void take_stream(StreamBuffer buffer)
+    {
+        m_map_data = buffer.data;
+        m_map_size = buffer.capacity;
+        m_data = static_cast<const char *>(buffer.data);
+        m_size = m_file_size = buffer.size;
+    }
+
+    // Copies [begin, end) of the file where it overlaps the view
+    void copy_range(BlockReader &reader, uint64_t begin, uint64_t end)
+    {
+        begin = std::max<uint64_t>(begin, m_offset);
+        end = std::min<uint64_t>(end, m_offset + m_size);
+        if (begin < end) {
+            auto output = static_cast<char *>(m_map_data) + (begin - m_offset);
+            reader.read(begin, end - begin, output);
+        }
+    }
+
+    /*
+     * Walks top level boxes from the start of file, a malformed box ends
+     * the walk and the rest of the view stays zero
+     */
+    void load_metadata(BlockReader &reader)
+    {
+        constexpr size_t header_size = 8;
+        constexpr size_t large_header_size = 16;
+
+        uint64_t view_end = m_offset + m_size;
+        uint64_t box_offset = 0;
+        while (box_offset < view_end &&
+               m_file_size - box_offset >= header_size) {
+            std::array<char, large_header_size> header;
+            size_t header_read =
+                reader.read(box_offset, header.size(), header.data());
+
+            uint64_t box_size = read_be32(header.data());
+            uint64_t box_header_size = header_size;
+            if (box_size == 1) {
+                if (header_read < large_header_size) {
+                    break;
+                }
+                box_size = uint64_t(read_be32(header.data() + 8)) << 32 |
+                    read_be32(header.data() + 12);
+                box_header_size = large_header_size;
+            } else if (box_size == 0) {
+                box_size = m_file_size - box_offset;
+            }
+
+            if (box_size < box_header_size ||
+                box_size > m_file_size - box_offset) {
+                break;
+            }
+
+            uint64_t box_end = box_offset + box_size;
+            if (is_payload_skipped(header.data() + 4)) {
+                copy_range(reader, box_offset, box_offset + box_header_size);
+            } else {
+                copy_range(reader, box_offset, box_end);
+            }
+            box_offset = box_end;
+        }
+    }
+};
+
+FileView::FileView(const char *name)
+    : FileView(name, 0, SIZE_MAX)
+{
+}
+
+FileView::FileView(const char *name, const FileViewOptions &options)
+    : FileView(name, 0, SIZE_MAX, options)
+{
+}
+
+// Options are mapping hints, the file is not mapped
+FileView::FileView(
+    const char *name,
+    size_t offset,
+    size_t size,
+    const FileViewOptions &)
+{
+    new (impl) FileView::Impl(name, offset, size);
+}
+
+FileView::FileView(int fd, const FileViewOptions &)
+{
+    new (impl) FileView::Impl(fd);
+}
+
+FileView::FileView(std::span<const std::byte> data)
+{
+    new (impl) FileView::Impl(data);
+}
+
+FileView::FileView(const StreamRead &read)
+{
+    new (impl) FileView::Impl(read);
+}
+
+FileView::FileView(FileView &&other) noexcept
+{
+    new (impl) FileView::Impl(std::move(Impl::cast(other)));
+}
+
+FileView &FileView::operator=(FileView &&other) noexcept
+{
+    if (this != &other) {
+        Impl::cast(*this).~Impl();
+        new (impl) FileView::Impl(std::move(Impl::cast(other)));
+    }
+    return *this;
+}
+
+const char *FileView::data()
+{
+    return Impl::cast(*this).data();
+}
+
+size_t FileView::size() const
+{
+    return Impl::cast(*this).size();
+}
+
+size_t FileView::offset() const
+{
+    return Impl::cast(*this).offset();
+}
+
+size_t FileView::file_size() const
+{
+    return Impl::cast(*this).file_size();
+}
+
+// Only metadata is held and it can not be read back, nothing to drop
+void FileView::release(size_t, size_t)
+{
+}
+
+void FileView::advise(size_t, size_t, FileAdvice)
+{
+}
+
+FileView::~FileView()
+{
+    Impl::cast(*this).~Impl();
+}
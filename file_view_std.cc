@@ -4,37 +4,62 @@
 #include <array>
 #include <format>
 #include <fstream>
+#include <iostream>
 #include <iterator>
 #include <optional>
 #include <ranges>
 #include <stdexcept>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include <cstddef>
 #include <cstdint>
 
 namespace {
-std::optional<std::vector<uint8_t>> load_file(const char *file_name)
+struct LoadedFile
 {
-    std::vector<uint8_t> output;
+    std::vector<uint8_t> data;
+    size_t file_size;
+};
+
+std::optional<LoadedFile> load_file(
+    const char *file_name,
+    size_t offset,
+    size_t size)
+{
+    LoadedFile output;
 
     std::ifstream f;
-    f.open(file_name, f.binary);
+    f.open(file_name, f.binary | f.ate);
 
     if (!f.is_open()) {
         return std::nullopt;
     }
 
+    output.file_size = f.tellg();
+    if (offset > output.file_size) {
+        return std::nullopt;
+    }
+    size = std::min(size, output.file_size - offset);
+    f.seekg(offset);
+
     std::array<char, 8196> read_buff;
     size_t readen = 0;
 
-    while (!f.eof()) {
-        f.read(read_buff.data(), read_buff.size());
+    output.data.reserve(size);
+    while (output.data.size() < size && !f.eof()) {
+        f.read(
+            read_buff.data(),
+            std::min(read_buff.size(), size - output.data.size()));
         readen = f.gcount();
+        if (readen == 0) {
+            break;
+        }
 
         std::ranges::copy(
-            read_buff | std::views::take(readen), std::back_inserter(output));
+            read_buff | std::views::take(readen),
+            std::back_inserter(output.data));
     }
 
     return output;
@@ -60,40 +85,151 @@ struct FileView::Impl
         return true;
     }
 
-    Impl(const char *name)
+    Impl(const char *name, size_t offset, size_t size)
     {
-        auto data_mb = load_file(name);
+        auto data_mb = load_file(name, offset, size);
         if (!data_mb.has_value()) {
             throw std::runtime_error(
                 std::format("File \"{}\" open failue", name));
         }
 
-        m_data = *data_mb;
+        m_data = std::move(data_mb->data);
+        m_view = reinterpret_cast<const char *>(m_data.data());
+        m_size = m_data.size();
+        m_offset = offset;
+        m_file_size = data_mb->file_size;
+    }
+
+    Impl(std::span<const std::byte> data)
+        : m_view(reinterpret_cast<const char *>(data.data())),
+          m_size(data.size()),
+          m_file_size(data.size())
+    {
+    }
+
+    Impl(const FileView::StreamRead &read)
+    {
+        constexpr size_t read_size = 64 * 1024;
+
+        while (true) {
+            size_t used = m_data.size();
+            m_data.resize(used + read_size);
+            size_t count = read(
+                reinterpret_cast<std::byte *>(m_data.data() + used),
+                read_size);
+            m_data.resize(used + count);
+            if (count == 0) {
+                break;
+            }
+        }
+
+        m_view = reinterpret_cast<const char *>(m_data.data());
+        m_size = m_file_size = m_data.size();
     }
 
     Impl(const Impl &) = delete;
-    Impl(Impl &&) = delete;
+    Impl(Impl &&other) noexcept
+        : m_data(std::move(other.m_data)),
+          m_view(std::exchange(other.m_view, nullptr)),
+          m_size(std::exchange(other.m_size, 0)),
+          m_offset(std::exchange(other.m_offset, 0)),
+          m_file_size(std::exchange(other.m_file_size, 0))
+    {
+        other.m_data.clear();
+    }
     Impl &operator=(const Impl &) = delete;
     Impl &operator=(Impl &&) = delete;
     ~Impl() = default;
 
     const char *data()
     {
-        return reinterpret_cast<const char *>(m_data.data());
+        return m_view;
     }
 
     size_t size() const
     {
-        return m_data.size();
+        return m_size;
+    }
+
+    size_t offset() const
+    {
+        return m_offset;
+    }
+
+    size_t file_size() const
+    {
+        return m_file_size;
     }
 
   private:
+    // Loaded data, empty for borrowed data
     std::vector<uint8_t> m_data;
+    const char *m_view = nullptr;
+    size_t m_size = 0;
+    size_t m_offset = 0;
+    size_t m_file_size = 0;
 };
 
 FileView::FileView(const char *name)
+    : FileView(name, 0, SIZE_MAX)
+{
+}
+
+FileView::FileView(const char *name, const FileViewOptions &options)
+    : FileView(name, 0, SIZE_MAX, options)
+{
+}
+
+// Options are hints, the view is read into memory at once anyway
+FileView::FileView(
+    const char *name,
+    size_t offset,
+    size_t size,
+    const FileViewOptions &)
+{
+    new (impl) FileView::Impl(name, offset, size);
+}
+
+// There are no file descriptors in the C++ API, only std::cin for stdin
+FileView::FileView(int fd, const FileViewOptions &)
+{
+    constexpr int stdin_fd = 0;
+    if (fd != stdin_fd) {
+        throw std::runtime_error(std::format(
+            "File descriptor {} can not be viewed with C++ API FileView", fd));
+    }
+
+    new (impl) FileView::Impl([](std::byte *buffer, size_t size) -> size_t {
+        std::cin.read(reinterpret_cast<char *>(buffer), size);
+        if (std::cin.bad()) {
+            throw std::runtime_error("Standard input read failue");
+        }
+        return std::cin.gcount();
+    });
+}
+
+FileView::FileView(std::span<const std::byte> data)
 {
-    new (impl) FileView::Impl(name);
+    new (impl) FileView::Impl(data);
+}
+
+FileView::FileView(const StreamRead &read)
+{
+    new (impl) FileView::Impl(read);
+}
+
+FileView::FileView(FileView &&other) noexcept
+{
+    new (impl) FileView::Impl(std::move(Impl::cast(other)));
+}
+
+FileView &FileView::operator=(FileView &&other) noexcept
+{
+    if (this != &other) {
+        Impl::cast(*this).~Impl();
+        new (impl) FileView::Impl(std::move(Impl::cast(other)));
+    }
+    return *this;
 }
 
 const char *FileView::data()
@@ -106,8 +242,26 @@ size_t FileView::size() const
     return Impl::cast(*this).size();
 }
 
+size_t FileView::offset() const
+{
+    return Impl::cast(*this).offset();
+}
+
+size_t FileView::file_size() const
+{
+    return Impl::cast(*this).file_size();
+}
+
+// Whole file is loaded into memory, nothing to drop
+void FileView::release(size_t, size_t)
+{
+}
+
+void FileView::advise(size_t, size_t, FileAdvice)
+{
+}
+
 FileView::~FileView()
 {
     Impl::cast(*this).~Impl();
 }
-
@@ -1,14 +1,18 @@
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <format>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
+#include <io.h>
 #include <errhandlingapi.h>
 #include <fileapi.h>
 #include <handleapi.h>
@@ -78,10 +82,16 @@ struct FileView::Impl
         return true;
     }
 
-    Impl(const char *file_name) : m_file_name(file_name)
+    Impl(
+        const char *file_name,
+        size_t offset,
+        size_t size,
+        const FileViewOptions &options
+    )
     {
+        std::string_view name(file_name);
         auto convert_size = MultiByteToWideChar(
-            CP_UTF8, 0, m_file_name.c_str(), m_file_name.size(), nullptr, 0
+            CP_UTF8, 0, name.data(), name.size(), nullptr, 0
         );
         if (convert_size == 0) {
             auto status = GetLastError();
@@ -100,8 +110,8 @@ struct FileView::Impl
         convert_size = MultiByteToWideChar(
             CP_UTF8,
             0,
-            m_file_name.c_str(),
-            m_file_name.size(),
+            name.data(),
+            name.size(),
             file_name_wstr.data(),
             file_name_wstr.size()
         );
@@ -136,89 +146,359 @@ struct FileView::Impl
             ));
         }
 
-        auto map_handle =
-            CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
-        if (nullptr == map_handle) {
-            auto status = GetLastError();
+        try {
+            map_file(handle, file_name, offset, size, options);
+        } catch (...) {
             CloseHandle(handle);
-            throw std::runtime_error(std::format(
-                "Create Maping object for file \"{}\" failue, status {} ({})",
-                file_name,
-                status,
-                win32_strerr(status)
-            ));
+            throw;
         }
+        m_file_handle = handle;
+    }
 
-        auto data = MapViewOfFile(map_handle, FILE_MAP_READ, 0, 0, 0);
-        if (data == nullptr) {
-            auto status = GetLastError();
-            CloseHandle(map_handle);
-            CloseHandle(handle);
-            throw std::runtime_error(std::format(
-                "Maping file \"{}\" failue, status {} ({})",
-                file_name,
-                status,
-                win32_strerr(status)
-            ));
+    Impl(int fd, const FileViewOptions &options)
+    {
+        std::string name = std::format("<fd {}>", fd);
+
+        auto handle = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+        if (INVALID_HANDLE_VALUE == handle) {
+            throw std::runtime_error(
+                std::format("File \"{}\" is not open", name)
+            );
         }
 
-        m_file_handle = handle;
-        m_file_map_handle = map_handle;
-        m_data = data;
+        // Handle stays owned by the fd, the mapping outlives it
+        if (GetFileType(handle) == FILE_TYPE_DISK) {
+            map_file(handle, name.c_str(), 0, SIZE_MAX, options);
+            return;
+        }
+
+        take_stream([&](std::byte *buffer, size_t size) -> size_t {
+            DWORD count = 0;
+            DWORD read_size = std::min<size_t>(size, MAXDWORD);
+            if (!ReadFile(handle, buffer, read_size, &count, nullptr)) {
+                auto status = GetLastError();
+                // Write end of a pipe was closed
+                if (status == ERROR_BROKEN_PIPE) {
+                    return 0;
+                }
+                throw std::runtime_error(std::format(
+                    "Read \"{}\" failue, status {} ({})",
+                    name,
+                    status,
+                    win32_strerr(status)
+                ));
+            }
+            return count;
+        });
+    }
+
+    Impl(std::span<const std::byte> data)
+        : m_data(reinterpret_cast<const char *>(data.data())),
+          m_size(data.size()),
+          m_file_size(data.size())
+    {
+    }
+
+    Impl(const FileView::StreamRead &read)
+    {
+        take_stream(read);
     }
 
     Impl(const Impl &) = delete;
-    Impl(Impl &&) = delete;
+    Impl(Impl &&other) noexcept
+        : m_file_handle(
+              std::exchange(other.m_file_handle, INVALID_HANDLE_VALUE)
+          ),
+          m_file_map_handle(std::exchange(other.m_file_map_handle, nullptr)),
+          m_map_data(std::exchange(other.m_map_data, nullptr)),
+          m_data(std::exchange(other.m_data, nullptr)),
+          m_is_allocated(std::exchange(other.m_is_allocated, false)),
+          m_offset(std::exchange(other.m_offset, 0)),
+          m_size(std::exchange(other.m_size, 0)),
+          m_file_size(std::exchange(other.m_file_size, 0))
+    {
+    }
 
     Impl &operator=(const Impl &) = delete;
     Impl &operator=(Impl &&) = delete;
 
     const char *data()
     {
-        return static_cast<const char *>(m_data);
+        return m_data;
     }
     size_t size() const
     {
-        return full_map_size();
+        return m_size;
+    }
+    size_t offset() const
+    {
+        return m_offset;
+    }
+    size_t file_size() const
+    {
+        return m_file_size;
+    }
+
+    void release(size_t offset, size_t size)
+    {
+        // Only views of files can be read back after being dropped
+        if (m_file_map_handle == nullptr || offset >= m_size) {
+            return;
+        }
+
+        /*
+         * Unlocking pages that are not locked removes them from the
+         * working set, failure (ERROR_NOT_LOCKED) is expected
+         */
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        uintptr_t page_size = info.dwPageSize;
+        uintptr_t begin = reinterpret_cast<uintptr_t>(m_data + offset);
+        uintptr_t end = reinterpret_cast<uintptr_t>(
+            m_data + offset + std::min(size, m_size - offset)
+        );
+        begin = (begin + page_size - 1) / page_size * page_size;
+        end = end / page_size * page_size;
+        if (begin >= end) {
+            return;
+        }
+
+        VirtualUnlock(reinterpret_cast<void *>(begin), end - begin);
+    }
+
+    void advise(size_t offset, size_t size, FileAdvice advice)
+    {
+        if (advice == FileAdvice::DONT_NEED) {
+            release(offset, size);
+            return;
+        }
+        // Readahead of a view is not tunable, only prefetch is
+        if (advice != FileAdvice::WILL_NEED || m_file_map_handle == nullptr ||
+            offset >= m_size) {
+            return;
+        }
+
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = const_cast<char *>(m_data + offset);
+        range.NumberOfBytes = std::min(size, m_size - offset);
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
     }
 
     ~Impl()
     {
-        UnmapViewOfFile(m_data);
-        CloseHandle(m_file_map_handle);
-        CloseHandle(m_file_handle);
+        if (m_map_data != nullptr && m_is_allocated) {
+            VirtualFree(const_cast<void *>(m_map_data), 0, MEM_RELEASE);
+        } else if (m_map_data != nullptr) {
+            UnmapViewOfFile(m_map_data);
+        }
+        if (m_file_map_handle != nullptr) {
+            CloseHandle(m_file_map_handle);
+        }
+        if (m_file_handle != INVALID_HANDLE_VALUE) {
+            CloseHandle(m_file_handle);
+        }
     }
 
   private:
-    size_t full_map_size() const
+    void map_file(
+        HANDLE handle,
+        const char *file_name,
+        size_t offset,
+        size_t size,
+        const FileViewOptions &options
+    )
     {
-        MEMORY_BASIC_INFORMATION i;
-        std::memset(&i, 0, sizeof(i));
-        size_t info_size = VirtualQuery(m_data, &i, sizeof(i));
-        if (info_size == 0) {
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(handle, &file_size)) {
             auto status = GetLastError();
             throw std::runtime_error(std::format(
-                "Aftermap sizeof file \"{}\" retreave failue, status {} "
-                "({})",
-                m_file_name,
+                "Size of file \"{}\" retreave failue, status {} ({})",
+                file_name,
                 status,
                 win32_strerr(status)
             ));
         }
+        m_file_size = file_size.QuadPart;
+        if (offset > m_file_size) {
+            throw std::runtime_error(std::format(
+                "File \"{}\" offset {} is past the end ({})",
+                file_name,
+                offset,
+                m_file_size
+            ));
+        }
+        m_offset = offset;
+        m_size = std::min(size, m_file_size - offset);
+        if (m_size == 0) {
+            return;
+        }
 
-        return i.RegionSize;
+        auto map_handle =
+            CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (nullptr == map_handle) {
+            auto status = GetLastError();
+            throw std::runtime_error(std::format(
+                "Create Maping object for file \"{}\" failue, status {} ({})",
+                file_name,
+                status,
+                win32_strerr(status)
+            ));
+        }
+
+        // View offset must be aligned to allocation granularity
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        uint64_t granularity = info.dwAllocationGranularity;
+        uint64_t map_offset = offset / granularity * granularity;
+        size_t map_size = m_size + (offset - map_offset);
+
+        auto data = MapViewOfFile(
+            map_handle,
+            FILE_MAP_READ,
+            static_cast<DWORD>(map_offset >> 32),
+            static_cast<DWORD>(map_offset),
+            map_size
+        );
+        if (data == nullptr) {
+            auto status = GetLastError();
+            CloseHandle(map_handle);
+            throw std::runtime_error(std::format(
+                "Maping file \"{}\" failue, status {} ({})",
+                file_name,
+                status,
+                win32_strerr(status)
+            ));
+        }
+
+        m_file_map_handle = map_handle;
+        m_map_data = data;
+        m_data = static_cast<const char *>(data) + (offset - map_offset);
+
+        // Large pages are not available for file backed sections
+        if (options.advice != FileAdvice::NORMAL) {
+            advise(0, m_size, options.advice);
+        }
+        if (options.populate) {
+            advise(0, m_size, FileAdvice::WILL_NEED);
+        }
+    }
+
+    // Reads to the end of stream into memory growing by doubling
+    void take_stream(const FileView::StreamRead &read)
+    {
+        constexpr size_t initial_capacity = 1024 * 1024;
+
+        char *buffer = nullptr;
+        size_t capacity = 0;
+        size_t used = 0;
+        try {
+            while (true) {
+                if (used == capacity) {
+                    size_t new_capacity =
+                        std::max(capacity * 2, initial_capacity);
+                    auto new_buffer = static_cast<char *>(VirtualAlloc(
+                        nullptr,
+                        new_capacity,
+                        MEM_RESERVE | MEM_COMMIT,
+                        PAGE_READWRITE
+                    ));
+                    if (new_buffer == nullptr) {
+                        auto status = GetLastError();
+                        throw std::runtime_error(std::format(
+                            "Stream buffer allocation failue, status {} ({})",
+                            status,
+                            win32_strerr(status)
+                        ));
+                    }
+                    if (buffer != nullptr) {
+                        std::memcpy(new_buffer, buffer, used);
+                        VirtualFree(buffer, 0, MEM_RELEASE);
+                    }
+                    buffer = new_buffer;
+                    capacity = new_capacity;
+                }
+
+                size_t count = read(
+                    reinterpret_cast<std::byte *>(buffer + used),
+                    capacity - used
+                );
+                if (count == 0) {
+                    break;
+                }
+                used += count;
+            }
+        } catch (...) {
+            if (buffer != nullptr) {
+                VirtualFree(buffer, 0, MEM_RELEASE);
+            }
+            throw;
+        }
+
+        m_map_data = buffer;
+        m_is_allocated = true;
+        m_data = buffer;
+        m_size = m_file_size = used;
     }
 
-    std::string m_file_name;
     HANDLE m_file_handle = INVALID_HANDLE_VALUE;
     HANDLE m_file_map_handle = nullptr;
-    const void *m_data = nullptr;
+    const void *m_map_data = nullptr;
+    const char *m_data = nullptr;
+    // m_map_data is a stream buffer, not a view of a file
+    bool m_is_allocated = false;
+    size_t m_offset = 0;
+    size_t m_size = 0;
+    size_t m_file_size = 0;
 };
 
 
 FileView::FileView(const char *name)
+    : FileView(name, 0, SIZE_MAX)
 {
-    new (impl) FileView::Impl(name);
+}
+
+FileView::FileView(const char *name, const FileViewOptions &options)
+    : FileView(name, 0, SIZE_MAX, options)
+{
+}
+
+FileView::FileView(
+    const char *name,
+    size_t offset,
+    size_t size,
+    const FileViewOptions &options
+)
+{
+    new (impl) FileView::Impl(name, offset, size, options);
+}
+
+FileView::FileView(int fd, const FileViewOptions &options)
+{
+    new (impl) FileView::Impl(fd, options);
+}
+
+FileView::FileView(std::span<const std::byte> data)
+{
+    new (impl) FileView::Impl(data);
+}
+
+FileView::FileView(const StreamRead &read)
+{
+    new (impl) FileView::Impl(read);
+}
+
+FileView::FileView(FileView &&other) noexcept
+{
+    new (impl) FileView::Impl(std::move(Impl::cast(other)));
+}
+
+FileView &FileView::operator=(FileView &&other) noexcept
+{
+    if (this != &other) {
+        Impl::cast(*this).~Impl();
+        new (impl) FileView::Impl(std::move(Impl::cast(other)));
+    }
+    return *this;
 }
 
 const char *FileView::data()
@@ -231,6 +511,26 @@ size_t FileView::size() const
     return Impl::cast(*this).size();
 }
 
+size_t FileView::offset() const
+{
+    return Impl::cast(*this).offset();
+}
+
+size_t FileView::file_size() const
+{
+    return Impl::cast(*this).file_size();
+}
+
+void FileView::release(size_t offset, size_t size)
+{
+    Impl::cast(*this).release(offset, size);
+}
+
+void FileView::advise(size_t offset, size_t size, FileAdvice advice)
+{
+    Impl::cast(*this).advise(offset, size, advice);
+}
+
 FileView::~FileView()
 {
     Impl::cast(*this).~Impl();
@@ -0,0 +1,270 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "libmedia/mpeg4/box/TrackFragmentHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/TrackRunBoxView.hh"
+
+#include "box_test_util.hh"
+
+using Mpeg4::TrackFragmentHeaderBoxView;
+using Mpeg4::TrackRunBoxView;
+
+constexpr TrackRunBoxView::Entry trun_defaults{100, 200, 0x10000, 0};
+
+constexpr uint32_t trun_first_sample_flags = 0x2000000;
+
+// Per sample values of the test run
+constexpr uint32_t trun_duration(uint32_t sample) { return 10 + sample; }
+constexpr uint32_t trun_size(uint32_t sample) { return 1000 + sample; }
+constexpr uint32_t trun_flags(uint32_t sample) { return 0x1010000 + sample; }
+constexpr uint32_t trun_offset(uint32_t sample)
+{
+    // Negative as int32_t for odd samples
+    return sample % 2 == 0 ? sample : uint32_t(-int32_t(sample));
+}
+
+constexpr uint32_t trun_sample_count = 2;
+
+constexpr std::vector<std::byte> make_trun(uint8_t version, uint32_t flags)
+{
+    TestPayload payload;
+    payload.u32(trun_sample_count);
+    if ((flags & TrackRunBoxView::data_offset_present) != 0) {
+        payload.u32(0xffffff00);
+    }
+    if ((flags & TrackRunBoxView::first_sample_flags_present) != 0) {
+        payload.u32(trun_first_sample_flags);
+    }
+    for (uint32_t sample = 0; sample < trun_sample_count; sample++) {
+        if ((flags & TrackRunBoxView::sample_duration_present) != 0) {
+            payload.u32(trun_duration(sample));
+        }
+        if ((flags & TrackRunBoxView::sample_size_present) != 0) {
+            payload.u32(trun_size(sample));
+        }
+        if ((flags & TrackRunBoxView::sample_flags_present) != 0) {
+            payload.u32(trun_flags(sample));
+        }
+        if ((flags &
+             TrackRunBoxView::sample_composition_time_offsets_present) != 0) {
+            payload.u32(trun_offset(sample));
+        }
+    }
+    return make_full_box("trun", version, flags, payload);
+}
+
+constexpr bool check_trun_entry(
+    const TrackRunBoxView::Entry &entry,
+    uint8_t version,
+    uint32_t flags,
+    uint32_t sample)
+{
+    auto expected = trun_defaults;
+    if ((flags & TrackRunBoxView::sample_duration_present) != 0) {
+        expected.sample_duration = trun_duration(sample);
+    }
+    if ((flags & TrackRunBoxView::sample_size_present) != 0) {
+        expected.sample_size = trun_size(sample);
+    }
+    if ((flags & TrackRunBoxView::sample_flags_present) != 0) {
+        expected.sample_flags = trun_flags(sample);
+    }
+    if (sample == 0 &&
+        (flags & TrackRunBoxView::first_sample_flags_present) != 0) {
+        expected.sample_flags = trun_first_sample_flags;
+    }
+    if ((flags & TrackRunBoxView::sample_composition_time_offsets_present) !=
+        0) {
+        expected.sample_composition_time_offset = version == 0
+            ? int64_t(trun_offset(sample))
+            : int64_t(int32_t(trun_offset(sample)));
+    }
+
+    return entry.sample_duration == expected.sample_duration &&
+        entry.sample_size == expected.sample_size &&
+        entry.sample_flags == expected.sample_flags &&
+        entry.sample_composition_time_offset ==
+        expected.sample_composition_time_offset;
+}
+
+constexpr bool test_trun(uint8_t version, uint32_t flags)
+{
+    auto data = make_trun(version, flags);
+    TrackRunBoxView trun(Mpeg4::BoxView{data});
+    if (!trun.is_valid() || trun.get_flags() != flags ||
+        trun.get_sample_count() != trun_sample_count) {
+        return false;
+    }
+
+    bool has_data_offset =
+        (flags & TrackRunBoxView::data_offset_present) != 0;
+    if (trun.get_data_offset() !=
+        (has_data_offset ? std::optional<int32_t>(-256) : std::nullopt)) {
+        return false;
+    }
+
+    std::array<TrackRunBoxView::Entry, trun_sample_count + 1> entries{};
+    if (trun.decode_entries(0, entries, trun_defaults) != trun_sample_count) {
+        return false;
+    }
+    for (uint32_t sample = 0; sample < trun_sample_count; sample++) {
+        auto entry = trun.get_entry(sample, trun_defaults);
+        if (!entry || !check_trun_entry(*entry, version, flags, sample) ||
+            !check_trun_entry(entries[sample], version, flags, sample)) {
+            return false;
+        }
+    }
+
+    // Decoding from the middle skips first_sample_flags
+    if (trun.decode_entries(1, entries, trun_defaults) !=
+            trun_sample_count - 1 ||
+        !check_trun_entry(entries[0], version, flags, 1)) {
+        return false;
+    }
+
+    if (trun.get_entry(trun_sample_count).has_value()) {
+        return false;
+    }
+
+    // Run cut one byte short
+    data.resize(data.size() - 1);
+    data[3] = std::byte(data.size());
+    return TrackRunBoxView(Mpeg4::BoxView{data}).is_not_valid() ||
+        (flags & 0xf00) == 0;
+}
+
+/*
+ * Every per sample field combination (one decoder each) with
+ * data_offset and first_sample_flags present
+ */
+consteval bool test_trun_fields(uint8_t version)
+{
+    for (uint32_t fields = 0; fields < 16; fields++) {
+        if (!test_trun(version, 0x5 | (fields << 8))) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(test_trun_fields(0));
+static_assert(test_trun_fields(1));
+
+// Remaining data_offset and first_sample_flags combinations
+consteval bool test_trun_header_fields(uint8_t version)
+{
+    for (uint32_t header_flags : {0x0, 0x1, 0x4}) {
+        if (!test_trun(version, header_flags) ||
+            !test_trun(version, header_flags | 0xf00)) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(test_trun_header_fields(0));
+static_assert(test_trun_header_fields(1));
+
+consteval bool test_trun_truncated_header()
+{
+    auto data = make_full_box("trun", 0, 0x5, TestPayload{}.u32(0));
+    return TrackRunBoxView(Mpeg4::BoxView{data}).is_not_valid();
+}
+static_assert(test_trun_truncated_header());
+
+constexpr uint32_t tfhd_field_flags[] = {
+    TrackFragmentHeaderBoxView::base_data_offset_present,
+    TrackFragmentHeaderBoxView::sample_description_index_present,
+    TrackFragmentHeaderBoxView::default_sample_duration_present,
+    TrackFragmentHeaderBoxView::default_sample_size_present,
+    TrackFragmentHeaderBoxView::default_sample_flags_present,
+};
+
+constexpr bool test_tfhd(uint32_t fields)
+{
+    uint32_t flags = TrackFragmentHeaderBoxView::default_base_is_moof;
+    for (size_t idx = 0; idx < std::size(tfhd_field_flags); idx++) {
+        if ((fields & (1u << idx)) != 0) {
+            flags |= tfhd_field_flags[idx];
+        }
+    }
+
+    TestPayload payload;
+    payload.u32(7); // track_ID
+    if ((flags & TrackFragmentHeaderBoxView::base_data_offset_present) != 0) {
+        payload.u64(0x100000000);
+    }
+    if ((flags &
+         TrackFragmentHeaderBoxView::sample_description_index_present) != 0) {
+        payload.u32(2);
+    }
+    if ((flags &
+         TrackFragmentHeaderBoxView::default_sample_duration_present) != 0) {
+        payload.u32(3);
+    }
+    if ((flags & TrackFragmentHeaderBoxView::default_sample_size_present) !=
+        0) {
+        payload.u32(4);
+    }
+    if ((flags & TrackFragmentHeaderBoxView::default_sample_flags_present) !=
+        0) {
+        payload.u32(5);
+    }
+
+    auto data = make_full_box("tfhd", 0, flags, payload);
+    TrackFragmentHeaderBoxView tfhd(Mpeg4::BoxView{data});
+    if (!tfhd.is_valid() || tfhd.get_flags() != flags ||
+        tfhd.get_track_ID() != 7) {
+        return false;
+    }
+
+    auto expect = [flags]<typename T>(
+                      std::optional<T> value,
+                      uint32_t present_flag,
+                      T expected) {
+        return (flags & present_flag) != 0 ? value == expected
+                                           : !value.has_value();
+    };
+    bool fields_ok =
+        expect(
+            tfhd.get_base_data_offset(),
+            TrackFragmentHeaderBoxView::base_data_offset_present,
+            uint64_t(0x100000000)) &&
+        expect(
+            tfhd.get_sample_description_index(),
+            TrackFragmentHeaderBoxView::sample_description_index_present,
+            uint32_t(2)) &&
+        expect(
+            tfhd.get_default_sample_duration(),
+            TrackFragmentHeaderBoxView::default_sample_duration_present,
+            uint32_t(3)) &&
+        expect(
+            tfhd.get_default_sample_size(),
+            TrackFragmentHeaderBoxView::default_sample_size_present,
+            uint32_t(4)) &&
+        expect(
+            tfhd.get_default_sample_flags(),
+            TrackFragmentHeaderBoxView::default_sample_flags_present,
+            uint32_t(5));
+    if (!fields_ok) {
+        return false;
+    }
+
+    // Last optional field cut short
+    data.resize(data.size() - 1);
+    data[3] = std::byte(data.size());
+    return TrackFragmentHeaderBoxView(Mpeg4::BoxView{data}).is_not_valid() ||
+        fields == 0;
+}
+
+consteval bool test_tfhd_combinations()
+{
+    for (uint32_t fields = 0; fields < 32; fields++) {
+        if (!test_tfhd(fields)) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(test_tfhd_combinations());
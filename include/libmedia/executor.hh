@@ -0,0 +1,78 @@
+#pragma once
+
+#include <concepts>
+#include <exception>
+#include <functional>
+#include <latch>
+#include <mutex>
+#include <utility>
+
+#include <cstddef>
+
+/*
+ * Caller supplied thread pool: anything accepting
+ * submit(std::function<void()>) and running the task eventually
+ */
+template <typename T>
+concept Executor = requires(T &executor, std::function<void()> task) {
+    executor.submit(std::move(task));
+};
+
+// Runs tasks on the submitting thread, for callers without a pool
+struct InlineExecutor
+{
+    void submit(std::function<void()> task)
+    {
+        task();
+    }
+};
+
+static_assert(Executor<InlineExecutor>);
+
+/*
+ * Runs task(idx) for idx in [0, count) on executor and waits for all
+ *
+ * The first exception thrown by a task is rethrown once all tasks have
+ * finished. Blocks the calling thread, must not be called from a task
+ * running on a pool that can not grow, or the pool may deadlock
+ */
+template <Executor E, std::invocable<size_t> F>
+void parallel_for(E &executor, size_t count, const F &task)
+{
+    if (count == 0) {
+        return;
+    }
+
+    std::latch done(count);
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto set_error = [&](std::exception_ptr current) {
+        std::lock_guard lock(error_mutex);
+        if (!error) {
+            error = std::move(current);
+        }
+    };
+
+    for (size_t idx = 0; idx < count; idx++) {
+        try {
+            executor.submit([&task, &done, &set_error, idx]() {
+                try {
+                    task(idx);
+                } catch (...) {
+                    set_error(std::current_exception());
+                }
+                done.count_down();
+            });
+        } catch (...) {
+            // Tasks never submitted are counted as done
+            set_error(std::current_exception());
+            done.count_down(count - idx);
+            break;
+        }
+    }
+    done.wait();
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
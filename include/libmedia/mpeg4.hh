@@ -172,11 +172,11 @@ struct BoxView
 
 struct FullBoxView
 {
-    FullBoxView(BoxView box) : m_box(box)
+    constexpr FullBoxView(BoxView box) : m_box(box)
     {
     }
 
-    std::optional<FullBoxHeader> get_header() const
+    constexpr std::optional<FullBoxHeader> get_header() const
     {
         auto header = m_box.get_header();
         auto version = get_version();
@@ -188,7 +188,7 @@ struct FullBoxView
         return FullBoxHeader{header.value(), version.value(), flags.value()};
     }
 
-    std::optional<std::span<const std::byte>> get_data() const
+    constexpr std::optional<std::span<const std::byte>> get_data() const
     {
         auto box_data_opt = m_box.get_content_data();
         if (!box_data_opt) {
@@ -202,7 +202,7 @@ struct FullBoxView
         return box_data.subspan(4);
     }
 
-    std::optional<uint8_t> get_version() const
+    constexpr std::optional<uint8_t> get_version() const
     {
         auto box_data_opt = m_box.get_content_data();
         if (!box_data_opt) {
@@ -217,7 +217,18 @@ struct FullBoxView
         return std::to_integer<uint8_t>(box_data[0]);
     }
 
-    std::optional<std::bitset<24>> get_flags() const
+    constexpr std::optional<std::bitset<24>> get_flags() const
+    {
+        auto flags = get_flags_value();
+        if (!flags) {
+            return std::nullopt;
+        }
+
+        return std::bitset<24>(flags.value());
+    }
+
+    // Flags as an integer, for testing several flag bits at once
+    constexpr std::optional<uint32_t> get_flags_value() const
     {
         auto box_data_opt = m_box.get_content_data();
         if (!box_data_opt) {
@@ -229,11 +240,11 @@ struct FullBoxView
             return std::nullopt;
         }
 
-        std::bitset<24> output = 0;
-        auto bitset_data = box_data.subspan<1, 3>();
-        output |= std::to_integer<uint8_t>(bitset_data[0]) << (8 * 2);
-        output |= std::to_integer<uint8_t>(bitset_data[1]) << (8 * 1);
-        output |= std::to_integer<uint8_t>(bitset_data[2]) << (8 * 0);
+        auto flags_data = box_data.subspan<1, 3>();
+        uint32_t output = 0;
+        output |= std::to_integer<uint8_t>(flags_data[0]) << (8 * 2);
+        output |= std::to_integer<uint8_t>(flags_data[1]) << (8 * 1);
+        output |= std::to_integer<uint8_t>(flags_data[2]) << (8 * 0);
         return output;
     }
 
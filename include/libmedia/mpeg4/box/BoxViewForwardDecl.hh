@@ -4,13 +4,30 @@ namespace Mpeg4 {
 struct ChunkOffset64BoxView;
 struct ChunkOffsetBoxView;
 struct ChunkOffsetBoxView;
+struct EditListBoxView;
 struct FileTypeBoxView;
 struct ForwardDecl;
 struct HandlerBoxView;
 struct MediaHeaderBoxView;
+struct MovieExtendsHeaderBoxView;
+struct MovieFragmentHeaderBoxView;
+struct MovieFragmentRandomAccessBoxView;
+struct MovieFragmentRandomAccessOffsetBoxView;
 struct MovieHeaderBoxView;
+struct SampleDependencyTypeBoxView;
 struct SampleDescriptionBoxView;
 struct SampleEntryBoxView;
+struct SampleGroupDescriptionBoxView;
 struct SampleSizeBoxView;
+struct SampleToChunkBoxView;
+struct SampleToGroupBoxView;
+struct SegmentIndexBoxView;
+struct SyncSampleBoxView;
+struct TimeToSampleBoxView;
+struct TrackExtendsBoxView;
+struct TrackFragmentBaseMediaDecodeTimeBoxView;
+struct TrackFragmentHeaderBoxView;
+struct TrackFragmentRandomAccessBoxView;
 struct TrackHeaderBoxView;
+struct TrackRunBoxView;
 } // namespace Mpeg4
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <optional>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+#include "libmedia/raw_data.hh"
+
+namespace Mpeg4 {
+
+struct EditListBoxView
+{
+    constexpr static TypeTag elst_tag = TypeTag::from_str("elst");
+
+    struct Entry
+    {
+        uint64_t segment_duration;
+        int64_t media_time;
+        int16_t media_rate_integer;
+        int16_t media_rate_fraction;
+
+        // media_time of -1 marks an empty edit (no media is presented)
+        constexpr bool is_empty() const
+        {
+            return media_time == -1;
+        }
+
+        // media_rate of 0 marks a dwell edit (media_time is held)
+        constexpr bool is_dwell() const
+        {
+            return media_rate_integer == 0 && media_rate_fraction == 0;
+        }
+    };
+
+    constexpr EditListBoxView(FullBoxView box) : m_box(box)
+    {
+    }
+
+    constexpr bool validate() const
+    {
+        std::optional<FullBoxHeader> full_header = m_box.get_header();
+        auto data = m_box.get_data();
+        auto version = m_box.get_version();
+        if (!full_header || !data || !version) {
+            return false;
+        }
+
+        switch (version.value()) {
+        case 0:
+        case 1:
+            break;
+        default:
+            return false;
+        }
+
+        BoxHeader base_header = full_header->header;
+        if (full_header->header.type != elst_tag) {
+            return false;
+        }
+
+        size_t required_size = 0;
+        required_size += sizeof(uint32_t); // entry_count
+        if (required_size > data->size()) {
+            return false;
+        }
+
+        uint32_t entry_count = read_be<uint32_t>(data.value());
+        required_size += entry_count * entry_size(version.value());
+        if (required_size > data->size()) {
+            return false;
+        }
+
+        return true;
+    }
+
+    constexpr bool is_valid() const
+    {
+        return validate();
+    }
+
+    constexpr bool is_not_valid() const
+    {
+        return !is_valid();
+    }
+
+    constexpr std::optional<uint32_t> get_entry_count() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+        auto data = m_box.get_data().value().subspan(0);
+
+        return read_be<uint32_t>(data);
+    }
+
+    constexpr std::optional<Entry> get_entry(uint32_t entry_index) const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        auto entry_count = get_entry_count();
+        if (!entry_count) {
+            return std::nullopt;
+        }
+
+        if (entry_count.value() <= entry_index) {
+            return std::nullopt;
+        }
+
+        return get_entry_unsafe(entry_index);
+    }
+
+    constexpr Entry get_entry_unsafe(uint32_t entry_index) const
+    {
+        uint8_t version = m_box.get_version().value();
+
+        size_t offset = 0;
+        offset += sizeof(uint32_t); // entry_count
+        offset += entry_size(version) * entry_index;
+        auto data = m_box.get_data()->subspan(offset);
+
+        Entry output;
+        if (version == 1) {
+            output.segment_duration = read_be<uint64_t>(data);
+            data = data.subspan(sizeof(uint64_t));
+            output.media_time =
+                static_cast<int64_t>(read_be<uint64_t>(data));
+            data = data.subspan(sizeof(uint64_t));
+        } else {
+            output.segment_duration = read_be<uint32_t>(data);
+            data = data.subspan(sizeof(uint32_t));
+            output.media_time = static_cast<int32_t>(read_be<uint32_t>(data));
+            data = data.subspan(sizeof(uint32_t));
+        }
+
+        output.media_rate_integer =
+            static_cast<int16_t>(read_be<uint16_t>(data));
+        data = data.subspan(sizeof(uint16_t));
+        output.media_rate_fraction =
+            static_cast<int16_t>(read_be<uint16_t>(data));
+
+        return output;
+    }
+
+  private:
+    FullBoxView m_box;
+
+    static constexpr size_t entry_size(uint8_t version)
+    {
+        size_t output = 0;
+        if (version == 1) {
+            output += sizeof(uint64_t); // segment_duration v1
+            output += sizeof(uint64_t); // media_time v1
+        } else {
+            output += sizeof(uint32_t); // segment_duration v0
+            output += sizeof(uint32_t); // media_time v0
+        }
+        output += sizeof(uint16_t); // media_rate_integer
+        output += sizeof(uint16_t); // media_rate_fraction
+        return output;
+    }
+};
+
+} // namespace Mpeg4
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <optional>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+#include "libmedia/raw_data.hh"
+
+namespace Mpeg4 {
+
+struct MovieExtendsHeaderBoxView
+{
+    constexpr static TypeTag mehd_tag = TypeTag::from_str("mehd");
+
+    MovieExtendsHeaderBoxView(FullBoxView box) : m_box(box)
+    {
+    }
+
+    bool validate() const
+    {
+        std::optional<FullBoxHeader> full_header = m_box.get_header();
+        auto data = m_box.get_data();
+        auto version = m_box.get_version();
+        if (!full_header || !data || !version) {
+            return false;
+        }
+
+        BoxHeader base_header = full_header->header;
+        if (full_header->header.type != mehd_tag) {
+            return false;
+        }
+
+        size_t required_size = 0;
+        if (version.value() == 1) {
+            required_size += sizeof(uint64_t); // fragment_duration v1
+        } else {
+            required_size += sizeof(uint32_t); // fragment_duration v0
+        }
+        if (required_size > data->size()) {
+            return false;
+        }
+
+        return true;
+    }
+
+    bool is_valid() const
+    {
+        return validate();
+    }
+
+    bool is_not_valid() const
+    {
+        return !is_valid();
+    }
+
+    std::optional<uint64_t> get_fragment_duration() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        auto data = m_box.get_data().value();
+        if (m_box.get_version().value() == 1) {
+            return read_be<uint64_t>(data);
+        }
+        return read_be<uint32_t>(data);
+    }
+
+  private:
+    FullBoxView m_box;
+};
+
+} // namespace Mpeg4
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <optional>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+#include "libmedia/mpeg4/box_sequence.hh"
+
+#include "libmedia/mpeg4/box/TrackFragmentRandomAccessBoxView.hh"
+
+namespace Mpeg4 {
+
+// Container of one tfra per track followed by mfro
+struct MovieFragmentRandomAccessBoxView
+{
+    constexpr static TypeTag mfra_tag = TypeTag::from_str("mfra");
+
+    MovieFragmentRandomAccessBoxView(BoxView box) : m_box(box)
+    {
+    }
+
+    bool validate() const
+    {
+        auto header = m_box.get_header();
+        auto data = m_box.get_content_data();
+        if (!header || !data) {
+            return false;
+        }
+
+        if (header->type != mfra_tag) {
+            return false;
+        }
+
+        return true;
+    }
+
+    bool is_valid() const
+    {
+        return validate();
+    }
+
+    bool is_not_valid() const
+    {
+        return !is_valid();
+    }
+
+    std::optional<uint32_t> get_tfra_count() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        uint32_t output = 0;
+        BoxSequence children(m_box.get_content_data().value());
+        while (auto child = children.next()) {
+            if (TrackFragmentRandomAccessBoxView(child.value()).is_valid()) {
+                output++;
+            }
+        }
+        return output;
+    }
+
+    std::optional<TrackFragmentRandomAccessBoxView>
+        get_tfra(uint32_t tfra_index) const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        BoxSequence children(m_box.get_content_data().value());
+        while (auto child = children.next()) {
+            TrackFragmentRandomAccessBoxView tfra(child.value());
+            if (tfra.is_not_valid()) {
+                continue;
+            }
+            if (tfra_index == 0) {
+                return tfra;
+            }
+            tfra_index--;
+        }
+        return std::nullopt;
+    }
+
+  private:
+    BoxView m_box;
+};
+
+} // namespace Mpeg4
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <optional>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+#include "libmedia/raw_data.hh"
+
+namespace Mpeg4 {
+
+struct MovieFragmentRandomAccessOffsetBoxView
+{
+    constexpr static TypeTag mfro_tag = TypeTag::from_str("mfro");
+
+    // mfro is the last box of mfra and the last 16 bytes of the file
+    constexpr static size_t box_size = 16;
+
+    MovieFragmentRandomAccessOffsetBoxView(FullBoxView box) : m_box(box)
+    {
+    }
+
+    bool validate() const
+    {
+        std::optional<FullBoxHeader> full_header = m_box.get_header();
+        auto data = m_box.get_data();
+        auto version = m_box.get_version();
+        if (!full_header || !data || !version) {
+            return false;
+        }
+
+        BoxHeader base_header = full_header->header;
+        if (full_header->header.type != mfro_tag) {
+            return false;
+        }
+
+        size_t required_size = 0;
+        required_size += sizeof(uint32_t); // parent_size
+        if (required_size > data->size()) {
+            return false;
+        }
+
+        return true;
+    }
+
+    bool is_valid() const
+    {
+        return validate();
+    }
+
+    bool is_not_valid() const
+    {
+        return !is_valid();
+    }
+
+    // Size of the enclosing mfra box
+    std::optional<uint32_t> get_parent_size() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        return read_be<uint32_t>(m_box.get_data().value());
+    }
+
+  private:
+    FullBoxView m_box;
+};
+
+} // namespace Mpeg4
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <optional>
+#include <span>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+#include "libmedia/raw_data.hh"
+
+namespace Mpeg4 {
+
+struct SampleDependencyTypeBoxView
+{
+    constexpr static TypeTag sdtp_tag = TypeTag::from_str("sdtp");
+
+    /*
+     * ISO/IEC 14496-12 8.6.4.3
+     * Each field is 2 bits: 0 - unknown, 1 - yes, 2 - no
+     * (sample_depends_on 2 means I picture,
+     * sample_is_depended_on 2 means disposable sample)
+     */
+    struct Entry
+    {
+        uint8_t is_leading;
+        uint8_t sample_depends_on;
+        uint8_t sample_is_depended_on;
+        uint8_t sample_has_redundancy;
+    };
+
+    constexpr SampleDependencyTypeBoxView(FullBoxView box) : m_box(box)
+    {
+    }
+
+    constexpr bool validate() const
+    {
+        std::optional<FullBoxHeader> full_header = m_box.get_header();
+        auto data = m_box.get_data();
+        auto version = m_box.get_version();
+        if (!full_header || !data || !version) {
+            return false;
+        }
+
+        BoxHeader base_header = full_header->header;
+        if (full_header->header.type != sdtp_tag) {
+            return false;
+        }
+
+        return true;
+    }
+
+    constexpr bool is_valid() const
+    {
+        return validate();
+    }
+
+    constexpr bool is_not_valid() const
+    {
+        return !is_valid();
+    }
+
+    /*
+     * Box has no entry_count field, it holds one byte per sample
+     * and sample count is taken from stsz/stz2
+     */
+    constexpr std::optional<uint32_t> get_entry_count() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+        return m_box.get_data().value().size();
+    }
+
+    constexpr std::optional<Entry> get_entry(uint32_t sample_index) const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        auto entry_count = get_entry_count();
+        if (!entry_count) {
+            return std::nullopt;
+        }
+
+        if (entry_count.value() <= sample_index) {
+            return std::nullopt;
+        }
+
+        return get_entry_unsafe(sample_index);
+    }
+
+    constexpr Entry get_entry_unsafe(uint32_t sample_index) const
+    {
+        auto data = m_box.get_data()->subspan(sample_index);
+        uint8_t packed = std::to_integer<uint8_t>(data[0]);
+
+        Entry output;
+        output.is_leading = (packed >> 6) & 0b11;
+        output.sample_depends_on = (packed >> 4) & 0b11;
+        output.sample_is_depended_on = (packed >> 2) & 0b11;
+        output.sample_has_redundancy = (packed >> 0) & 0b11;
+        return output;
+    }
+
+    // Packed entries for bulk decoding
+    constexpr std::optional<std::span<const std::byte>> get_entries_data() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+        return m_box.get_data().value();
+    }
+
+  private:
+    FullBoxView m_box;
+};
+
+} // namespace Mpeg4
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <optional>
+#include <span>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+#include "libmedia/raw_data.hh"
+
+namespace Mpeg4 {
+
+struct SampleGroupDescriptionBoxView
+{
+    constexpr static TypeTag sgpd_tag = TypeTag::from_str("sgpd");
+
+    constexpr SampleGroupDescriptionBoxView(FullBoxView box) : m_box(box)
+    {
+    }
+
+    constexpr bool validate() const
+    {
+        std::optional<FullBoxHeader> full_header = m_box.get_header();
+        auto data = m_box.get_data();
+        auto version = m_box.get_version();
+        if (!full_header || !data || !version) {
+            return false;
+        }
+
+        BoxHeader base_header = full_header->header;
+        if (full_header->header.type != sgpd_tag) {
+            return false;
+        }
+
+        size_t required_size = get_entries_offset(version.value());
+        if (required_size > data->size()) {
+            return false;
+        }
+
+        /*
+         * Entries of variable length are checked
+         * on access in get_entry()
+         */
+        auto default_length = get_default_length_unsafe();
+        if (default_length.value_or(0) != 0) {
+            uint32_t entry_count = get_entry_count_unsafe();
+            required_size += uint64_t(entry_count) * default_length.value();
+            if (required_size > data->size()) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    constexpr bool is_valid() const
+    {
+        return validate();
+    }
+
+    constexpr bool is_not_valid() const
+    {
+        return !is_valid();
+    }
+
+    constexpr std::optional<uint32_t> get_grouping_type() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        return read_be<uint32_t>(m_box.get_data().value());
+    }
+
+    // Present in version 1 and later, 0 means entries of variable length
+    constexpr std::optional<uint32_t> get_default_length() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        return get_default_length_unsafe();
+    }
+
+    /*
+     * Present in version 2 and later, applies to samples
+     * not mapped by any sbgp of the same grouping type
+     */
+    constexpr std::optional<uint32_t>
+        get_default_group_description_index() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        if (m_box.get_version().value() < 2) {
+            return std::nullopt;
+        }
+
+        auto data = m_box.get_data().value().subspan(sizeof(uint32_t) * 2);
+        return read_be<uint32_t>(data);
+    }
+
+    constexpr std::optional<uint32_t> get_entry_count() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        return get_entry_count_unsafe();
+    }
+
+    /*
+     * Payload of SampleGroupEntry, entry_index is 0-based
+     * (group_description_index - 1)
+     *
+     * Version 0 boxes do not store entry lengths, entries are assumed
+     * to share the box payload evenly
+     *
+     * Entries of variable length are located by walking
+     * the preceding ones: O(entry_index)
+     */
+    constexpr std::optional<std::span<const std::byte>>
+        get_entry(uint32_t entry_index) const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        uint32_t entry_count = get_entry_count_unsafe();
+        if (entry_count <= entry_index) {
+            return std::nullopt;
+        }
+
+        uint8_t version = m_box.get_version().value();
+        auto entries = m_box.get_data()->subspan(get_entries_offset(version));
+
+        uint32_t entry_length = get_default_length_unsafe().value_or(0);
+        if (version == 0) {
+            if (entries.size() % entry_count != 0) {
+                return std::nullopt;
+            }
+            entry_length = entries.size() / entry_count;
+        }
+
+        if (entry_length != 0) {
+            size_t offset = size_t(entry_index) * entry_length;
+            return entries.subspan(offset, entry_length);
+        }
+
+        size_t offset = 0;
+        for (uint32_t idx = 0; idx <= entry_index; idx++) {
+            if (offset + sizeof(uint32_t) > entries.size()) {
+                return std::nullopt;
+            }
+            uint32_t description_length =
+                read_be<uint32_t>(entries.subspan(offset));
+            offset += sizeof(uint32_t);
+
+            if (description_length > entries.size() - offset) {
+                return std::nullopt;
+            }
+            if (idx == entry_index) {
+                return entries.subspan(offset, description_length);
+            }
+            offset += description_length;
+        }
+
+        return std::nullopt;
+    }
+
+  private:
+    FullBoxView m_box;
+
+    constexpr std::optional<uint32_t> get_default_length_unsafe() const
+    {
+        if (m_box.get_version().value() < 1) {
+            return std::nullopt;
+        }
+
+        auto data = m_box.get_data().value().subspan(sizeof(uint32_t));
+        return read_be<uint32_t>(data);
+    }
+
+    constexpr uint32_t get_entry_count_unsafe() const
+    {
+        size_t offset = get_entries_offset(m_box.get_version().value());
+        auto data = m_box.get_data()->subspan(offset - sizeof(uint32_t));
+
+        return read_be<uint32_t>(data);
+    }
+
+    static constexpr size_t get_entries_offset(uint8_t version)
+    {
+        size_t offset = 0;
+        offset += sizeof(uint32_t); // grouping_type
+        if (version >= 1) {
+            offset += sizeof(uint32_t); // default_length
+        }
+        if (version >= 2) {
+            offset += sizeof(uint32_t); // default_group_description_index
+        }
+        offset += sizeof(uint32_t); // entry_count
+        return offset;
+    }
+};
+
+} // namespace Mpeg4
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <optional>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+#include "libmedia/raw_data.hh"
+
+namespace Mpeg4 {
+
+struct SampleToGroupBoxView
+{
+    constexpr static TypeTag sbgp_tag = TypeTag::from_str("sbgp");
+
+    struct Entry
+    {
+        uint32_t sample_count;
+        uint32_t group_description_index; // 0 - sample is in no group
+    };
+
+    constexpr SampleToGroupBoxView(FullBoxView box) : m_box(box)
+    {
+    }
+
+    constexpr bool validate() const
+    {
+        std::optional<FullBoxHeader> full_header = m_box.get_header();
+        auto data = m_box.get_data();
+        auto version = m_box.get_version();
+        if (!full_header || !data || !version) {
+            return false;
+        }
+
+        BoxHeader base_header = full_header->header;
+        if (full_header->header.type != sbgp_tag) {
+            return false;
+        }
+
+        size_t required_size = get_entries_offset(version.value());
+        if (required_size > data->size()) {
+            return false;
+        }
+
+        uint32_t entry_count = read_be<uint32_t>(
+            data->subspan(required_size - sizeof(uint32_t)));
+        required_size += entry_count * sizeof(uint32_t) * 2; // entries
+        if (required_size > data->size()) {
+            return false;
+        }
+
+        return true;
+    }
+
+    constexpr bool is_valid() const
+    {
+        return validate();
+    }
+
+    constexpr bool is_not_valid() const
+    {
+        return !is_valid();
+    }
+
+    constexpr std::optional<uint32_t> get_grouping_type() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        return read_be<uint32_t>(m_box.get_data().value());
+    }
+
+    constexpr std::optional<uint32_t> get_grouping_type_parameter() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        if (m_box.get_version().value() != 1) {
+            return std::nullopt;
+        }
+
+        auto data = m_box.get_data().value().subspan(sizeof(uint32_t));
+        return read_be<uint32_t>(data);
+    }
+
+    constexpr std::optional<uint32_t> get_entry_count() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        return get_entry_count_unsafe();
+    }
+
+    constexpr uint32_t get_entry_count_unsafe() const
+    {
+        size_t offset = get_entries_offset(m_box.get_version().value());
+        auto data = m_box.get_data()->subspan(offset - sizeof(uint32_t));
+
+        return read_be<uint32_t>(data);
+    }
+
+    constexpr std::optional<Entry> get_entry(uint32_t entry_index) const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        if (get_entry_count_unsafe() <= entry_index) {
+            return std::nullopt;
+        }
+
+        return get_entry_unsafe(entry_index);
+    }
+
+    constexpr Entry get_entry_unsafe(uint32_t entry_index) const
+    {
+        size_t offset = get_entries_offset(m_box.get_version().value());
+        offset += sizeof(uint32_t) * 2 * entry_index;
+        auto data = m_box.get_data()->subspan(offset);
+
+        Entry output;
+        output.sample_count = read_be<uint32_t>(data);
+        output.group_description_index =
+            read_be<uint32_t>(data.subspan(sizeof(uint32_t)));
+        return output;
+    }
+
+  private:
+    FullBoxView m_box;
+
+    static constexpr size_t get_entries_offset(uint8_t version)
+    {
+        size_t offset = 0;
+        offset += sizeof(uint32_t); // grouping_type
+        if (version == 1) {
+            offset += sizeof(uint32_t); // grouping_type_parameter
+        }
+        offset += sizeof(uint32_t); // entry_count
+        return offset;
+    }
+};
+
+} // namespace Mpeg4
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <optional>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+#include "libmedia/raw_data.hh"
+
+namespace Mpeg4 {
+
+struct SegmentIndexBoxView
+{
+    constexpr static TypeTag sidx_tag = TypeTag::from_str("sidx");
+
+    struct Reference
+    {
+        bool reference_type; // true - references another sidx
+        uint32_t referenced_size;
+        uint32_t subsegment_duration;
+        bool starts_with_SAP;
+        uint8_t SAP_type;
+        uint32_t SAP_delta_time;
+    };
+
+    constexpr SegmentIndexBoxView(FullBoxView box) : m_box(box)
+    {
+    }
+
+    constexpr bool validate() const
+    {
+        std::optional<FullBoxHeader> full_header = m_box.get_header();
+        auto data = m_box.get_data();
+        auto version = m_box.get_version();
+        if (!full_header || !data || !version) {
+            return false;
+        }
+
+        BoxHeader base_header = full_header->header;
+        if (full_header->header.type != sidx_tag) {
+            return false;
+        }
+
+        size_t required_size = get_references_offset(version.value());
+        if (required_size > data->size()) {
+            return false;
+        }
+
+        uint16_t reference_count = read_be<uint16_t>(
+            data->subspan(required_size - sizeof(uint16_t)));
+        required_size += reference_count * reference_size;
+        if (required_size > data->size()) {
+            return false;
+        }
+
+        return true;
+    }
+
+    constexpr bool is_valid() const
+    {
+        return validate();
+    }
+
+    constexpr bool is_not_valid() const
+    {
+        return !is_valid();
+    }
+
+    constexpr std::optional<uint32_t> get_reference_ID() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        return read_be<uint32_t>(m_box.get_data().value());
+    }
+
+    constexpr std::optional<uint32_t> get_timescale() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        auto data = m_box.get_data().value().subspan(sizeof(uint32_t));
+        return read_be<uint32_t>(data);
+    }
+
+    constexpr std::optional<uint64_t> get_earliest_presentation_time() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        auto data = m_box.get_data().value().subspan(sizeof(uint32_t) * 2);
+        if (m_box.get_version().value() == 0) {
+            return read_be<uint32_t>(data);
+        }
+        return read_be<uint64_t>(data);
+    }
+
+    // Distance from the first byte after this box to the first reference
+    constexpr std::optional<uint64_t> get_first_offset() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        auto data = m_box.get_data().value().subspan(sizeof(uint32_t) * 2);
+        if (m_box.get_version().value() == 0) {
+            return read_be<uint32_t>(data.subspan(sizeof(uint32_t)));
+        }
+        return read_be<uint64_t>(data.subspan(sizeof(uint64_t)));
+    }
+
+    constexpr std::optional<uint16_t> get_reference_count() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        size_t offset = get_references_offset(m_box.get_version().value());
+        auto data = m_box.get_data()->subspan(offset - sizeof(uint16_t));
+        return read_be<uint16_t>(data);
+    }
+
+    constexpr std::optional<Reference>
+        get_reference(uint16_t reference_index) const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        if (get_reference_count().value() <= reference_index) {
+            return std::nullopt;
+        }
+
+        return get_reference_unsafe(reference_index);
+    }
+
+    constexpr Reference get_reference_unsafe(uint16_t reference_index) const
+    {
+        size_t offset = get_references_offset(m_box.get_version().value());
+        offset += reference_size * reference_index;
+        auto data = m_box.get_data()->subspan(offset);
+
+        uint32_t type_and_size = read_be<uint32_t>(data);
+        uint32_t duration = read_be<uint32_t>(data.subspan(4));
+        uint32_t sap = read_be<uint32_t>(data.subspan(8));
+
+        Reference output;
+        output.reference_type = (type_and_size >> 31) != 0;
+        output.referenced_size = type_and_size & 0x7fffffff;
+        output.subsegment_duration = duration;
+        output.starts_with_SAP = (sap >> 31) != 0;
+        output.SAP_type = (sap >> 28) & 0x7;
+        output.SAP_delta_time = sap & 0x0fffffff;
+        return output;
+    }
+
+  private:
+    FullBoxView m_box;
+
+    constexpr static size_t reference_size = sizeof(uint32_t) * 3;
+
+    static constexpr size_t get_references_offset(uint8_t version)
+    {
+        size_t offset = 0;
+        offset += sizeof(uint32_t); // reference_ID
+        offset += sizeof(uint32_t); // timescale
+        if (version == 0) {
+            offset += sizeof(uint32_t); // earliest_presentation_time v0
+            offset += sizeof(uint32_t); // first_offset v0
+        } else {
+            offset += sizeof(uint64_t); // earliest_presentation_time v1
+            offset += sizeof(uint64_t); // first_offset v1
+        }
+        offset += sizeof(uint16_t); // reserved
+        offset += sizeof(uint16_t); // reference_count
+        return offset;
+    }
+};
+
+} // namespace Mpeg4
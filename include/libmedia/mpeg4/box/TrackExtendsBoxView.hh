@@ -0,0 +1,97 @@
+#pragma once
+
+#include <optional>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+#include "libmedia/raw_data.hh"
+
+namespace Mpeg4 {
+
+struct TrackExtendsBoxView
+{
+    constexpr static TypeTag trex_tag = TypeTag::from_str("trex");
+
+    TrackExtendsBoxView(FullBoxView box) : m_box(box)
+    {
+    }
+
+    bool validate() const
+    {
+        std::optional<FullBoxHeader> full_header = m_box.get_header();
+        auto data = m_box.get_data();
+        auto version = m_box.get_version();
+        if (!full_header || !data || !version) {
+            return false;
+        }
+
+        BoxHeader base_header = full_header->header;
+        if (full_header->header.type != trex_tag) {
+            return false;
+        }
+
+        size_t required_size = 0;
+        required_size += sizeof(uint32_t); // track_ID
+        required_size += sizeof(uint32_t); // default_sample_description_index
+        required_size += sizeof(uint32_t); // default_sample_duration
+        required_size += sizeof(uint32_t); // default_sample_size
+        required_size += sizeof(uint32_t); // default_sample_flags
+        if (required_size > data->size()) {
+            return false;
+        }
+
+        return true;
+    }
+
+    bool is_valid() const
+    {
+        return validate();
+    }
+
+    bool is_not_valid() const
+    {
+        return !is_valid();
+    }
+
+    std::optional<uint32_t> get_track_ID() const
+    {
+        return get_field(0);
+    }
+
+    std::optional<uint32_t> get_default_sample_description_index() const
+    {
+        return get_field(1);
+    }
+
+    std::optional<uint32_t> get_default_sample_duration() const
+    {
+        return get_field(2);
+    }
+
+    std::optional<uint32_t> get_default_sample_size() const
+    {
+        return get_field(3);
+    }
+
+    std::optional<uint32_t> get_default_sample_flags() const
+    {
+        return get_field(4);
+    }
+
+  private:
+    FullBoxView m_box;
+
+    std::optional<uint32_t> get_field(size_t field_index) const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        auto data = m_box.get_data()->subspan(sizeof(uint32_t) * field_index);
+        return read_be<uint32_t>(data);
+    }
+};
+
+} // namespace Mpeg4
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <optional>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+#include "libmedia/raw_data.hh"
+
+namespace Mpeg4 {
+
+struct TrackFragmentHeaderBoxView
+{
+    constexpr static TypeTag tfhd_tag = TypeTag::from_str("tfhd");
+
+    // ISO/IEC 14496-12 8.8.7.1
+    constexpr static uint32_t base_data_offset_present = 0x000001;
+    constexpr static uint32_t sample_description_index_present = 0x000002;
+    constexpr static uint32_t default_sample_duration_present = 0x000008;
+    constexpr static uint32_t default_sample_size_present = 0x000010;
+    constexpr static uint32_t default_sample_flags_present = 0x000020;
+    constexpr static uint32_t duration_is_empty = 0x010000;
+    constexpr static uint32_t default_base_is_moof = 0x020000;
+
+    constexpr TrackFragmentHeaderBoxView(FullBoxView box) : m_box(box)
+    {
+    }
+
+    constexpr bool validate() const
+    {
+        std::optional<FullBoxHeader> full_header = m_box.get_header();
+        auto data = m_box.get_data();
+        auto version = m_box.get_version();
+        if (!full_header || !data || !version) {
+            return false;
+        }
+
+        BoxHeader base_header = full_header->header;
+        if (full_header->header.type != tfhd_tag) {
+            return false;
+        }
+
+        uint32_t flags = m_box.get_flags_value().value();
+        size_t required_size = field_offset(flags, end_of_fields);
+        if (required_size > data->size()) {
+            return false;
+        }
+
+        return true;
+    }
+
+    constexpr bool is_valid() const
+    {
+        return validate();
+    }
+
+    constexpr bool is_not_valid() const
+    {
+        return !is_valid();
+    }
+
+    constexpr std::optional<uint32_t> get_flags() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        return m_box.get_flags_value().value();
+    }
+
+    constexpr std::optional<uint32_t> get_track_ID() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        return read_be<uint32_t>(m_box.get_data().value());
+    }
+
+    constexpr std::optional<uint64_t> get_base_data_offset() const
+    {
+        return get_field<uint64_t>(base_data_offset_present);
+    }
+
+    constexpr std::optional<uint32_t> get_sample_description_index() const
+    {
+        return get_field<uint32_t>(sample_description_index_present);
+    }
+
+    constexpr std::optional<uint32_t> get_default_sample_duration() const
+    {
+        return get_field<uint32_t>(default_sample_duration_present);
+    }
+
+    constexpr std::optional<uint32_t> get_default_sample_size() const
+    {
+        return get_field<uint32_t>(default_sample_size_present);
+    }
+
+    constexpr std::optional<uint32_t> get_default_sample_flags() const
+    {
+        return get_field<uint32_t>(default_sample_flags_present);
+    }
+
+  private:
+    FullBoxView m_box;
+
+    constexpr static uint32_t end_of_fields = 0x000040;
+
+    // Offset of optional field present_flag (or end of all fields)
+    static constexpr size_t field_offset(uint32_t flags, uint32_t present_flag)
+    {
+        size_t offset = 0;
+        offset += sizeof(uint32_t); // track_ID
+
+        auto skip = [&](uint32_t field_flag, size_t field_size) {
+            if (field_flag < present_flag && (flags & field_flag) != 0) {
+                offset += field_size;
+            }
+        };
+
+        skip(base_data_offset_present, sizeof(uint64_t));
+        skip(sample_description_index_present, sizeof(uint32_t));
+        skip(default_sample_duration_present, sizeof(uint32_t));
+        skip(default_sample_size_present, sizeof(uint32_t));
+        skip(default_sample_flags_present, sizeof(uint32_t));
+        return offset;
+    }
+
+    template <std::unsigned_integral T>
+    constexpr std::optional<T> get_field(uint32_t present_flag) const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        uint32_t flags = m_box.get_flags_value().value();
+        if ((flags & present_flag) == 0) {
+            return std::nullopt;
+        }
+
+        size_t offset = field_offset(flags, present_flag);
+        return read_be<T>(m_box.get_data()->subspan(offset));
+    }
+};
+
+} // namespace Mpeg4
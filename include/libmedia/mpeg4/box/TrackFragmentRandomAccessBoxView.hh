@@ -0,0 +1,170 @@
+#pragma once
+
+#include <optional>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+#include "libmedia/raw_data.hh"
+
+namespace Mpeg4 {
+
+struct TrackFragmentRandomAccessBoxView
+{
+    constexpr static TypeTag tfra_tag = TypeTag::from_str("tfra");
+
+    struct Entry
+    {
+        uint64_t time;
+        uint64_t moof_offset;
+        uint32_t traf_number;   // 1-based
+        uint32_t trun_number;   // 1-based
+        uint32_t sample_number; // 1-based
+    };
+
+    TrackFragmentRandomAccessBoxView(FullBoxView box) : m_box(box)
+    {
+    }
+
+    bool validate() const
+    {
+        std::optional<FullBoxHeader> full_header = m_box.get_header();
+        auto data = m_box.get_data();
+        auto version = m_box.get_version();
+        if (!full_header || !data || !version) {
+            return false;
+        }
+
+        BoxHeader base_header = full_header->header;
+        if (full_header->header.type != tfra_tag) {
+            return false;
+        }
+
+        size_t required_size = entries_offset;
+        if (required_size > data->size()) {
+            return false;
+        }
+
+        uint32_t entry_count =
+            read_be<uint32_t>(data->subspan(entries_offset - 4));
+        uint32_t lengths = read_be<uint32_t>(data->subspan(4));
+        required_size +=
+            uint64_t(entry_count) * get_entry_size(version.value(), lengths);
+        if (required_size > data->size()) {
+            return false;
+        }
+
+        return true;
+    }
+
+    bool is_valid() const
+    {
+        return validate();
+    }
+
+    bool is_not_valid() const
+    {
+        return !is_valid();
+    }
+
+    std::optional<uint32_t> get_track_ID() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        return read_be<uint32_t>(m_box.get_data().value());
+    }
+
+    std::optional<uint32_t> get_entry_count() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        auto data = m_box.get_data()->subspan(entries_offset - 4);
+        return read_be<uint32_t>(data);
+    }
+
+    std::optional<Entry> get_entry(uint32_t entry_index) const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        if (get_entry_count().value() <= entry_index) {
+            return std::nullopt;
+        }
+
+        return get_entry_unsafe(entry_index);
+    }
+
+    Entry get_entry_unsafe(uint32_t entry_index) const
+    {
+        uint8_t version = m_box.get_version().value();
+        auto data = m_box.get_data().value();
+        uint32_t lengths = read_be<uint32_t>(data.subspan(4));
+
+        size_t offset = entries_offset;
+        offset += get_entry_size(version, lengths) * entry_index;
+        data = data.subspan(offset);
+
+        Entry output;
+        if (version == 1) {
+            output.time = read_be<uint64_t>(data);
+            output.moof_offset = read_be<uint64_t>(data.subspan(8));
+            data = data.subspan(16);
+        } else {
+            output.time = read_be<uint32_t>(data);
+            output.moof_offset = read_be<uint32_t>(data.subspan(4));
+            data = data.subspan(8);
+        }
+
+        auto read_number = [&data](size_t size) {
+            uint32_t value = 0;
+            for (size_t idx = 0; idx < size; idx++) {
+                value = (value << 8) | std::to_integer<uint8_t>(data[idx]);
+            }
+            data = data.subspan(size);
+            return value;
+        };
+
+        output.traf_number = read_number(traf_number_size(lengths));
+        output.trun_number = read_number(trun_number_size(lengths));
+        output.sample_number = read_number(sample_number_size(lengths));
+        return output;
+    }
+
+  private:
+    FullBoxView m_box;
+
+    // track_ID, length_size_of_* fields, number_of_entry
+    constexpr static size_t entries_offset = sizeof(uint32_t) * 3;
+
+    static size_t traf_number_size(uint32_t lengths)
+    {
+        return ((lengths >> 4) & 0x3) + 1;
+    }
+
+    static size_t trun_number_size(uint32_t lengths)
+    {
+        return ((lengths >> 2) & 0x3) + 1;
+    }
+
+    static size_t sample_number_size(uint32_t lengths)
+    {
+        return (lengths & 0x3) + 1;
+    }
+
+    static size_t get_entry_size(uint8_t version, uint32_t lengths)
+    {
+        size_t size = version == 1 ? 16 : 8; // time + moof_offset
+        size += traf_number_size(lengths);
+        size += trun_number_size(lengths);
+        size += sample_number_size(lengths);
+        return size;
+    }
+};
+
+} // namespace Mpeg4
@@ -0,0 +1,298 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <span>
+#include <utility>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+#include "libmedia/raw_data.hh"
+
+namespace Mpeg4 {
+
+struct TrackRunBoxView
+{
+    constexpr static TypeTag trun_tag = TypeTag::from_str("trun");
+
+    // ISO/IEC 14496-12 8.8.8.1
+    constexpr static uint32_t data_offset_present = 0x000001;
+    constexpr static uint32_t first_sample_flags_present = 0x000004;
+    constexpr static uint32_t sample_duration_present = 0x000100;
+    constexpr static uint32_t sample_size_present = 0x000200;
+    constexpr static uint32_t sample_flags_present = 0x000400;
+    constexpr static uint32_t sample_composition_time_offsets_present =
+        0x000800;
+
+    /*
+     * Fields not stored in the run come from defaults passed by caller
+     * (tfhd defaults, then trex defaults)
+     */
+    struct Entry
+    {
+        uint32_t sample_duration;
+        uint32_t sample_size;
+        uint32_t sample_flags;
+        int64_t sample_composition_time_offset;
+    };
+
+    constexpr TrackRunBoxView(FullBoxView box) : m_box(box)
+    {
+    }
+
+    constexpr bool validate() const
+    {
+        std::optional<FullBoxHeader> full_header = m_box.get_header();
+        auto data = m_box.get_data();
+        auto version = m_box.get_version();
+        if (!full_header || !data || !version) {
+            return false;
+        }
+
+        BoxHeader base_header = full_header->header;
+        if (full_header->header.type != trun_tag) {
+            return false;
+        }
+
+        uint32_t flags = m_box.get_flags_value().value();
+        uint64_t required_size = get_entries_offset(flags);
+        if (required_size > data->size()) {
+            return false;
+        }
+
+        uint32_t sample_count = read_be<uint32_t>(data.value());
+        required_size += uint64_t(sample_count) * get_entry_size(flags);
+        if (required_size > data->size()) {
+            return false;
+        }
+
+        return true;
+    }
+
+    constexpr bool is_valid() const
+    {
+        return validate();
+    }
+
+    constexpr bool is_not_valid() const
+    {
+        return !is_valid();
+    }
+
+    constexpr std::optional<uint32_t> get_flags() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        return m_box.get_flags_value().value();
+    }
+
+    constexpr std::optional<uint32_t> get_sample_count() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        return read_be<uint32_t>(m_box.get_data().value());
+    }
+
+    // Relative to base data offset of tfhd (or moof start / previous run)
+    constexpr std::optional<int32_t> get_data_offset() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        uint32_t flags = get_flags_unsafe();
+        if ((flags & data_offset_present) == 0) {
+            return std::nullopt;
+        }
+
+        auto data = m_box.get_data()->subspan(sizeof(uint32_t));
+        return static_cast<int32_t>(read_be<uint32_t>(data));
+    }
+
+    constexpr std::optional<uint32_t> get_first_sample_flags() const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        uint32_t flags = get_flags_unsafe();
+        if ((flags & first_sample_flags_present) == 0) {
+            return std::nullopt;
+        }
+
+        size_t offset = sizeof(uint32_t); // sample_count
+        if ((flags & data_offset_present) != 0) {
+            offset += sizeof(uint32_t);
+        }
+        return read_be<uint32_t>(m_box.get_data()->subspan(offset));
+    }
+
+    constexpr std::optional<Entry>
+        get_entry(uint32_t entry_index, const Entry &defaults = {}) const
+    {
+        if (is_not_valid()) {
+            return std::nullopt;
+        }
+
+        if (get_sample_count().value() <= entry_index) {
+            return std::nullopt;
+        }
+
+        return get_entry_unsafe(entry_index, defaults);
+    }
+
+    constexpr Entry
+        get_entry_unsafe(uint32_t entry_index, const Entry &defaults = {}) const
+    {
+        Entry output;
+        decode_entries_unsafe(entry_index, std::span(&output, 1), defaults);
+        return output;
+    }
+
+    /*
+     * Decodes entries starting from first_entry into output,
+     * returns the number of entries decoded
+     *
+     * Every combination of per sample fields has its own loop with
+     * field presence known at compile time
+     */
+    constexpr uint32_t decode_entries(
+        uint32_t first_entry,
+        std::span<Entry> output,
+        const Entry &defaults = {}) const
+    {
+        if (is_not_valid()) {
+            return 0;
+        }
+
+        uint32_t sample_count = get_sample_count().value();
+        if (first_entry >= sample_count) {
+            return 0;
+        }
+
+        uint32_t count = std::min<uint64_t>(
+            output.size(), sample_count - first_entry);
+        decode_entries_unsafe(first_entry, output.subspan(0, count), defaults);
+        return count;
+    }
+
+  private:
+    FullBoxView m_box;
+
+    constexpr uint32_t get_flags_unsafe() const
+    {
+        return m_box.get_flags_value().value();
+    }
+
+    static constexpr size_t get_entries_offset(uint32_t flags)
+    {
+        size_t offset = 0;
+        offset += sizeof(uint32_t); // sample_count
+        if ((flags & data_offset_present) != 0) {
+            offset += sizeof(uint32_t); // data_offset
+        }
+        if ((flags & first_sample_flags_present) != 0) {
+            offset += sizeof(uint32_t); // first_sample_flags
+        }
+        return offset;
+    }
+
+    static constexpr size_t get_entry_size(uint32_t flags)
+    {
+        size_t size = 0;
+        size += (flags & sample_duration_present) != 0 ? 4 : 0;
+        size += (flags & sample_size_present) != 0 ? 4 : 0;
+        size += (flags & sample_flags_present) != 0 ? 4 : 0;
+        size += (flags & sample_composition_time_offsets_present) != 0 ? 4 : 0;
+        return size;
+    }
+
+    // Bits of decoder index: per sample fields of flags >> 8, then version
+    constexpr static uint32_t has_duration = 0x01;
+    constexpr static uint32_t has_size = 0x02;
+    constexpr static uint32_t has_flags = 0x04;
+    constexpr static uint32_t has_offset = 0x08;
+    constexpr static uint32_t signed_offsets = 0x10;
+
+    using Decoder = void (*)(
+        std::span<const std::byte>, std::span<Entry>, const Entry &);
+
+    template <uint32_t Fields>
+    static constexpr void decode_run(
+        std::span<const std::byte> entries,
+        std::span<Entry> output,
+        const Entry &defaults)
+    {
+        size_t position = 0;
+        auto read_field = [&entries, &position]() {
+            uint32_t value = read_be<uint32_t>(entries.subspan(position));
+            position += sizeof(uint32_t);
+            return value;
+        };
+
+        for (auto &entry : output) {
+            entry = defaults;
+            if constexpr ((Fields & has_duration) != 0) {
+                entry.sample_duration = read_field();
+            }
+            if constexpr ((Fields & has_size) != 0) {
+                entry.sample_size = read_field();
+            }
+            if constexpr ((Fields & has_flags) != 0) {
+                entry.sample_flags = read_field();
+            }
+            if constexpr ((Fields & has_offset) != 0) {
+                uint32_t offset = read_field();
+                if constexpr ((Fields & signed_offsets) != 0) {
+                    entry.sample_composition_time_offset =
+                        static_cast<int32_t>(offset);
+                } else {
+                    entry.sample_composition_time_offset = offset;
+                }
+            }
+        }
+    }
+
+    template <size_t... Fields>
+    static constexpr std::array<Decoder, sizeof...(Fields)>
+        make_decoders(std::index_sequence<Fields...>)
+    {
+        return {&decode_run<Fields>...};
+    }
+
+    // One decoder per combination of decoder index bits
+    static const std::array<Decoder, 32> decoders;
+
+    constexpr void decode_entries_unsafe(
+        uint32_t first_entry,
+        std::span<Entry> output,
+        const Entry &defaults) const
+    {
+        uint32_t flags = get_flags_unsafe();
+        auto entries = m_box.get_data()->subspan(get_entries_offset(flags));
+        entries = entries.subspan(first_entry * get_entry_size(flags));
+
+        uint32_t fields = (flags >> 8) & 0xf;
+        if (m_box.get_version().value() != 0) {
+            fields |= signed_offsets;
+        }
+        decoders[fields](entries, output, defaults);
+
+        if (first_entry == 0 && !output.empty() &&
+            (flags & first_sample_flags_present) != 0) {
+            output[0].sample_flags = get_first_sample_flags().value();
+        }
+    }
+};
+
+constexpr std::array<TrackRunBoxView::Decoder, 32> TrackRunBoxView::decoders =
+    TrackRunBoxView::make_decoders(std::make_index_sequence<32>{});
+
+} // namespace Mpeg4
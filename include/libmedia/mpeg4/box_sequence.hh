@@ -0,0 +1,105 @@
+#pragma once
+
+#include <initializer_list>
+#include <optional>
+#include <span>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+
+namespace Mpeg4 {
+
+/*
+ * Walks boxes stored back to back (file top level or container content)
+ * without descending into them
+ */
+struct BoxSequence
+{
+    BoxSequence(std::span<const std::byte> data) : m_data(data)
+    {
+    }
+
+    // Returns next complete box and moves past it
+    std::optional<BoxView> next()
+    {
+        auto remaining = m_data.subspan(m_position);
+        if (remaining.empty()) {
+            return std::nullopt;
+        }
+
+        BoxView box(remaining);
+        auto header = box.get_header();
+        auto content = box.get_content_data();
+        if (!header || !content) {
+            m_position = m_data.size();
+            return std::nullopt;
+        }
+
+        m_current_offset = m_position;
+        m_current_size = header->header_size + content->size();
+        m_position += m_current_size;
+
+        return BoxView(remaining.subspan(0, m_current_size));
+    }
+
+    // Offset from the sequence start of the box last returned by next()
+    size_t get_current_offset() const
+    {
+        return m_current_offset;
+    }
+
+    // Full size (with header) of the box last returned by next()
+    size_t get_current_size() const
+    {
+        return m_current_size;
+    }
+
+    size_t get_position() const
+    {
+        return m_position;
+    }
+
+  private:
+    std::span<const std::byte> m_data;
+    size_t m_position = 0;
+    size_t m_current_offset = 0;
+    size_t m_current_size = 0;
+};
+
+inline std::optional<BoxView>
+    find_box(std::span<const std::byte> data, TypeTag tag)
+{
+    BoxSequence boxes(data);
+    while (auto box = boxes.next()) {
+        if (box->get_header()->type == tag) {
+            return box;
+        }
+    }
+    return std::nullopt;
+}
+
+// Descends through containers, e.g. {moov, trak, mdia}
+inline std::optional<BoxView> find_box(
+    std::span<const std::byte> data, std::initializer_list<TypeTag> path)
+{
+    std::optional<BoxView> output;
+    for (auto &tag : path) {
+        if (output) {
+            auto content = output->get_content_data();
+            if (!content) {
+                return std::nullopt;
+            }
+            data = content.value();
+        }
+
+        output = find_box(data, tag);
+        if (!output) {
+            return std::nullopt;
+        }
+    }
+    return output;
+}
+
+} // namespace Mpeg4
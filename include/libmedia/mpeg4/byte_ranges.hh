@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4/sample_index.hh"
+
+namespace Mpeg4 {
+
+struct ByteRange
+{
+    uint64_t offset;
+    uint64_t size;
+
+    uint64_t end() const
+    {
+        return offset + size;
+    }
+};
+
+struct TimeRangeBytes
+{
+    uint32_t first_sample; // sync sample the range starts from
+    uint32_t end_sample;   // one past the last sample needed
+    std::vector<ByteRange> ranges;
+};
+
+/*
+ * Byte ranges covering samples decoded in [begin_dts, end_dts) of one track,
+ * starting from the preceding sync sample so the range is decodable
+ *
+ * Samples stored back to back (same chunk or adjacent chunks) are merged
+ * into one range. Ranges separated by no more than max_gap bytes are merged
+ * too, at the price of reading the gap
+ *
+ * Cost is O(log n) for the lookups plus O(k) for k returned samples
+ */
+template <SampleIndex Table>
+std::optional<TimeRangeBytes> time_range_to_byte_ranges(
+    const Table &table,
+    uint64_t begin_dts,
+    uint64_t end_dts,
+    uint64_t max_gap = 0)
+{
+    if (begin_dts >= end_dts) {
+        return std::nullopt;
+    }
+
+    auto first_sample = table.find_sample_at_time(begin_dts);
+    if (!first_sample) {
+        return std::nullopt;
+    }
+
+    auto sync_sample = table.find_sync_sample_before(first_sample.value());
+    uint32_t begin_sample = sync_sample.value_or(0);
+
+    uint32_t end_sample = table.get_sample_count();
+    auto last_sample = table.find_sample_at_time(end_dts - 1);
+    if (last_sample) {
+        end_sample = last_sample.value() + 1;
+    }
+
+    TimeRangeBytes output{begin_sample, end_sample, {}};
+    auto &ranges = output.ranges;
+
+    SampleCursor cursor(table);
+    bool file_ordered = true;
+    for (uint32_t sample_idx = begin_sample; sample_idx < end_sample;
+         sample_idx++) {
+        auto sample = cursor.get_sample_unsafe(sample_idx);
+        if (sample.size == 0) {
+            continue;
+        }
+
+        if (!ranges.empty()) {
+            auto &last = ranges.back();
+            if (sample.offset >= last.end() &&
+                sample.offset - last.end() <= max_gap) {
+                last.size = sample.offset + sample.size - last.offset;
+                continue;
+            }
+            file_ordered &= sample.offset >= last.end();
+        }
+        ranges.emplace_back(sample.offset, sample.size);
+    }
+
+    if (file_ordered) {
+        return output;
+    }
+
+    /*
+     * Chunks are not required to be stored in decode order,
+     * merge ranges once more in file order
+     */
+    std::ranges::sort(ranges, {}, &ByteRange::offset);
+
+    std::vector<ByteRange> merged;
+    merged.reserve(ranges.size());
+    for (auto &range : ranges) {
+        if (!merged.empty() &&
+            range.offset <= merged.back().end() + max_gap) {
+            auto &last = merged.back();
+            last.size = std::max(last.end(), range.end()) - last.offset;
+            continue;
+        }
+        merged.push_back(range);
+    }
+    ranges = std::move(merged);
+
+    return output;
+}
+
+} // namespace Mpeg4
@@ -0,0 +1,466 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4/sample_index.hh"
+#include "libmedia/mpeg4/sample_table.hh"
+#include "libmedia/varint.hh"
+
+namespace Mpeg4 {
+
+/*
+ * Compressed SampleTable for keeping many tracks resident
+ *
+ * Samples are grouped into blocks of block_size. Every block keeps
+ * a checkpoint (first sample offset and dts, last preceding sync sample)
+ * and encodes its samples as:
+ *  - sizes: frame of reference bit packing (block min size + fixed width)
+ *  - offsets: bitmap of samples not stored right after previous sample
+ *    plus zigzag varint gap for each of them
+ *  - durations: run length (count, delta) varint pairs
+ *  - sync flags: bitmap
+ *
+ * Any sample is reached by decoding at most one block, sequential reads
+ * go through SampleCursor which decodes every block only once
+ */
+struct CompactSampleTable
+{
+    static constexpr uint32_t block_size = 256;
+
+    using Sample = SampleTable::Sample;
+
+    static CompactSampleTable from_table(const SampleTable &table)
+    {
+        CompactSampleTable output;
+        output.m_sample_count = table.get_sample_count();
+        output.m_duration = table.get_duration();
+        output.m_all_sync = true;
+
+        uint32_t block_count =
+            (output.m_sample_count + block_size - 1) / block_size;
+        output.m_blocks.reserve(block_count);
+
+        uint32_t last_sync = no_sample;
+        std::array<Sample, block_size> samples;
+
+        for (uint32_t block_idx = 0; block_idx < block_count; block_idx++) {
+            uint32_t first = block_idx * block_size;
+            uint32_t count =
+                std::min(block_size, output.m_sample_count - first);
+
+            for (uint32_t idx = 0; idx < count; idx++) {
+                samples[idx] = table.get_sample_unsafe(first + idx);
+                output.m_all_sync &= samples[idx].is_sync;
+            }
+
+            output.append_block(
+                std::span(samples).subspan(0, count), last_sync);
+
+            for (uint32_t idx = 0; idx < count; idx++) {
+                if (samples[idx].is_sync) {
+                    last_sync = first + idx;
+                }
+            }
+        }
+
+        output.m_bits.shrink_to_fit();
+        output.m_bytes.shrink_to_fit();
+        return output;
+    }
+
+    uint32_t get_sample_count() const
+    {
+        return m_sample_count;
+    }
+
+    uint64_t get_duration() const
+    {
+        return m_duration;
+    }
+
+    uint32_t get_block_count() const
+    {
+        return m_blocks.size();
+    }
+
+    // Heap and object bytes held by the table
+    size_t get_memory_usage() const
+    {
+        size_t output = sizeof(*this);
+        output += m_blocks.capacity() * sizeof(Block);
+        output += m_bits.capacity() * sizeof(uint64_t);
+        output += m_bytes.capacity() * sizeof(uint8_t);
+        return output;
+    }
+
+    std::optional<Sample> get_sample(uint32_t sample_index) const
+    {
+        if (sample_index >= m_sample_count) {
+            return std::nullopt;
+        }
+        return get_sample_unsafe(sample_index);
+    }
+
+    Sample get_sample_unsafe(uint32_t sample_index) const
+    {
+        uint32_t block_idx = sample_index / block_size;
+        uint32_t target = sample_index % block_size;
+        auto &block = m_blocks[block_idx];
+        BlockLayout layout = get_layout(block_idx);
+
+        size_t byte_pos = block.bytes_pos;
+
+        Sample output;
+        output.dts = block.dts;
+        output.duration = 0;
+        uint32_t run_first = 0;
+        for (uint32_t run = 0; run < block.run_count; run++) {
+            uint32_t count = read_varint(m_bytes, byte_pos);
+            uint32_t delta = read_varint(m_bytes, byte_pos);
+            if (target < run_first + count) {
+                output.dts += uint64_t(target - run_first) * delta;
+                output.duration = delta;
+                // skip rest of the runs to reach gaps
+                for (run++; run < block.run_count; run++) {
+                    read_varint(m_bytes, byte_pos);
+                    read_varint(m_bytes, byte_pos);
+                }
+                break;
+            }
+            output.dts += uint64_t(count) * delta;
+            run_first += count;
+        }
+
+        uint64_t offset = block.offset;
+        for (uint32_t idx = 0; idx <= target; idx++) {
+            if (idx != 0 && test_bit(layout.gaps_bitmap, idx)) {
+                offset += zigzag_decode(read_varint(m_bytes, byte_pos));
+            }
+            uint32_t size = block.min_size +
+                unpack(layout.sizes, idx, block.size_bits);
+            if (idx == target) {
+                output.offset = offset;
+                output.size = size;
+                break;
+            }
+            offset += size;
+        }
+
+        output.is_sync = m_all_sync || test_bit(layout.sync_bitmap, target);
+        return output;
+    }
+
+    /*
+     * Decodes every sample of the block, returns number of decoded samples
+     *
+     * Sizes and flags are unpacked by plain fixed-width loops
+     * the compiler vectorizes, offsets and times are prefix sums over them
+     */
+    uint32_t decode_block(
+        uint32_t block_idx, std::span<Sample, block_size> output) const
+    {
+        auto &block = m_blocks[block_idx];
+        BlockLayout layout = get_layout(block_idx);
+        uint32_t count = layout.sample_count;
+
+        std::array<uint32_t, block_size> sizes;
+        unpack_all(
+            layout.sizes, count, block.size_bits, block.min_size, sizes);
+
+        size_t byte_pos = block.bytes_pos;
+
+        uint64_t dts = block.dts;
+        uint32_t idx = 0;
+        for (uint32_t run = 0; run < block.run_count; run++) {
+            uint32_t run_count = read_varint(m_bytes, byte_pos);
+            uint32_t delta = read_varint(m_bytes, byte_pos);
+            for (uint32_t run_idx = 0; run_idx < run_count; run_idx++) {
+                output[idx].dts = dts;
+                output[idx].duration = delta;
+                dts += delta;
+                idx++;
+            }
+        }
+
+        uint64_t offset = block.offset;
+        for (idx = 0; idx < count; idx++) {
+            if (idx != 0 && test_bit(layout.gaps_bitmap, idx)) {
+                offset += zigzag_decode(read_varint(m_bytes, byte_pos));
+            }
+            output[idx].offset = offset;
+            output[idx].size = sizes[idx];
+            output[idx].is_sync =
+                m_all_sync || test_bit(layout.sync_bitmap, idx);
+            offset += sizes[idx];
+        }
+
+        return count;
+    }
+
+    // Sample being decoded at dts, std::nullopt past the last sample
+    std::optional<uint32_t> find_sample_at_time(uint64_t dts) const
+    {
+        if (dts >= m_duration) {
+            return std::nullopt;
+        }
+
+        auto block_it =
+            std::ranges::upper_bound(m_blocks, dts, {}, &Block::dts);
+        block_it--;
+        uint32_t block_idx = std::distance(std::begin(m_blocks), block_it);
+
+        size_t byte_pos = block_it->bytes_pos;
+        uint64_t run_dts = block_it->dts;
+        uint32_t sample_idx = block_idx * block_size;
+
+        for (uint32_t run = 0; run < block_it->run_count; run++) {
+            uint32_t count = read_varint(m_bytes, byte_pos);
+            uint32_t delta = read_varint(m_bytes, byte_pos);
+            uint64_t run_end = run_dts + uint64_t(count) * delta;
+            if (delta != 0 && dts < run_end) {
+                return sample_idx + (dts - run_dts) / delta;
+            }
+            run_dts = run_end;
+            sample_idx += count;
+        }
+
+        return std::nullopt;
+    }
+
+    // Last sync sample at or before sample_index
+    std::optional<uint32_t> find_sync_sample_before(uint32_t sample_index) const
+    {
+        if (sample_index >= m_sample_count) {
+            return std::nullopt;
+        }
+        if (m_all_sync) {
+            return sample_index;
+        }
+
+        uint32_t block_idx = sample_index / block_size;
+        uint32_t local = sample_index % block_size;
+        BlockLayout layout = get_layout(block_idx);
+
+        for (int64_t word = local / 64; word >= 0; word--) {
+            uint64_t bits = layout.sync_bitmap[word];
+            if (word == local / 64) {
+                uint32_t keep = local % 64 + 1;
+                if (keep < 64) {
+                    bits &= (uint64_t(1) << keep) - 1;
+                }
+            }
+            if (bits != 0) {
+                return block_idx * block_size + word * 64 +
+                    std::bit_width(bits) - 1;
+            }
+        }
+
+        uint32_t last_sync = m_blocks[block_idx].last_sync;
+        if (last_sync == no_sample) {
+            return std::nullopt;
+        }
+        return last_sync;
+    }
+
+  private:
+    static constexpr uint32_t no_sample = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t bitmap_words = block_size / 64;
+
+    struct Block
+    {
+        uint64_t offset; // first sample offset
+        uint64_t dts;    // first sample dts
+        uint32_t bits_pos;
+        uint32_t bytes_pos;
+        uint32_t min_size;
+        uint32_t last_sync; // last sync sample before the block
+        uint16_t run_count;
+        uint8_t size_bits;
+    };
+
+    struct BlockLayout
+    {
+        uint32_t sample_count;
+        std::span<const uint64_t> sizes;
+        std::span<const uint64_t> gaps_bitmap;
+        std::span<const uint64_t> sync_bitmap;
+    };
+
+    uint32_t m_sample_count = 0;
+    uint64_t m_duration = 0;
+    bool m_all_sync = true;
+
+    std::vector<Block> m_blocks;
+    std::vector<uint64_t> m_bits;
+    std::vector<uint8_t> m_bytes;
+
+    CompactSampleTable() = default;
+
+    static size_t packed_words(uint32_t count, uint8_t bits)
+    {
+        return (size_t(count) * bits + 63) / 64;
+    }
+
+    BlockLayout get_layout(uint32_t block_idx) const
+    {
+        auto &block = m_blocks[block_idx];
+
+        BlockLayout output;
+        output.sample_count =
+            std::min(block_size, m_sample_count - block_idx * block_size);
+
+        auto bits = std::span(m_bits).subspan(block.bits_pos);
+        size_t sizes_words =
+            packed_words(output.sample_count, block.size_bits);
+        output.sizes = bits.subspan(0, sizes_words);
+        output.gaps_bitmap = bits.subspan(sizes_words, bitmap_words);
+        output.sync_bitmap =
+            bits.subspan(sizes_words + bitmap_words, bitmap_words);
+        return output;
+    }
+
+    static bool test_bit(std::span<const uint64_t> bitmap, uint32_t idx)
+    {
+        return (bitmap[idx / 64] >> (idx % 64)) & 1;
+    }
+
+    static uint32_t
+        unpack(std::span<const uint64_t> words, uint32_t idx, uint8_t bits)
+    {
+        if (bits == 0) {
+            return 0;
+        }
+        size_t bit_pos = size_t(idx) * bits;
+        size_t word = bit_pos / 64;
+        size_t shift = bit_pos % 64;
+
+        uint64_t value = words[word] >> shift;
+        if (shift + bits > 64) {
+            value |= words[word + 1] << (64 - shift);
+        }
+        return value & ((uint64_t(1) << bits) - 1);
+    }
+
+    static void unpack_all(
+        std::span<const uint64_t> words,
+        uint32_t count,
+        uint8_t bits,
+        uint32_t base,
+        std::span<uint32_t, block_size> output)
+    {
+        if (bits == 0) {
+            std::ranges::fill(output, base);
+            return;
+        }
+
+        for (uint32_t idx = 0; idx < count; idx++) {
+            output[idx] = base + unpack(words, idx, bits);
+        }
+    }
+
+    void append_block(std::span<const Sample> samples, uint32_t last_sync)
+    {
+        Block block;
+        block.offset = samples[0].offset;
+        block.dts = samples[0].dts;
+        block.bits_pos = m_bits.size();
+        block.bytes_pos = m_bytes.size();
+        block.last_sync = last_sync;
+
+        auto [min_it, max_it] =
+            std::ranges::minmax_element(samples, {}, &Sample::size);
+        block.min_size = min_it->size;
+        block.size_bits = std::bit_width(max_it->size - min_it->size);
+
+        size_t sizes_pos = m_bits.size();
+        m_bits.resize(
+            m_bits.size() + packed_words(samples.size(), block.size_bits) +
+            bitmap_words * 2);
+        size_t gaps_pos = m_bits.size() - bitmap_words * 2;
+        size_t sync_pos = m_bits.size() - bitmap_words;
+
+        for (size_t idx = 0; idx < samples.size(); idx++) {
+            uint64_t value = samples[idx].size - block.min_size;
+            size_t bit_pos = idx * block.size_bits;
+            size_t word = sizes_pos + bit_pos / 64;
+            size_t shift = bit_pos % 64;
+            if (block.size_bits != 0) {
+                m_bits[word] |= value << shift;
+                if (shift + block.size_bits > 64) {
+                    m_bits[word + 1] |= value >> (64 - shift);
+                }
+            }
+
+            if (samples[idx].is_sync) {
+                m_bits[sync_pos + idx / 64] |= uint64_t(1) << (idx % 64);
+            }
+        }
+
+        block.run_count = 0;
+        size_t run_first = 0;
+        for (size_t idx = 1; idx <= samples.size(); idx++) {
+            if (idx != samples.size() &&
+                samples[idx].duration == samples[run_first].duration) {
+                continue;
+            }
+            write_varint(m_bytes, idx - run_first);
+            write_varint(m_bytes, samples[run_first].duration);
+            block.run_count++;
+            run_first = idx;
+        }
+
+        for (size_t idx = 1; idx < samples.size(); idx++) {
+            uint64_t expected = samples[idx - 1].offset + samples[idx - 1].size;
+            if (samples[idx].offset == expected) {
+                continue;
+            }
+            m_bits[gaps_pos + idx / 64] |= uint64_t(1) << (idx % 64);
+            write_varint(
+                m_bytes,
+                zigzag_encode(
+                    static_cast<int64_t>(samples[idx].offset - expected)));
+        }
+
+        m_blocks.push_back(block);
+    }
+};
+
+static_assert(SampleIndex<CompactSampleTable>);
+
+// Keeps the last block decoded by decode_block
+template <>
+struct SampleCursor<CompactSampleTable>
+{
+    using Sample = CompactSampleTable::Sample;
+    static constexpr uint32_t block_size = CompactSampleTable::block_size;
+
+    explicit SampleCursor(const CompactSampleTable &table) : m_table(&table)
+    {
+    }
+
+    Sample get_sample_unsafe(uint32_t sample_index)
+    {
+        uint32_t block_idx = sample_index / block_size;
+        if (block_idx != m_block_idx) {
+            m_table->decode_block(block_idx, m_samples);
+            m_block_idx = block_idx;
+        }
+        return m_samples[sample_index % block_size];
+    }
+
+  private:
+    const CompactSampleTable *m_table;
+    uint32_t m_block_idx = std::numeric_limits<uint32_t>::max();
+    std::array<Sample, block_size> m_samples;
+};
+
+} // namespace Mpeg4
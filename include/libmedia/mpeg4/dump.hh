@@ -16,14 +16,31 @@
 
 #include "libmedia/mpeg4/box/ChunkOffset64BoxView.hh"
 #include "libmedia/mpeg4/box/ChunkOffsetBoxView.hh"
+#include "libmedia/mpeg4/box/EditListBoxView.hh"
 #include "libmedia/mpeg4/box/FileTypeBoxView.hh"
 #include "libmedia/mpeg4/box/HandlerBoxView.hh"
 #include "libmedia/mpeg4/box/MediaHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/MovieExtendsHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/MovieFragmentHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/MovieFragmentRandomAccessBoxView.hh"
+#include "libmedia/mpeg4/box/MovieFragmentRandomAccessOffsetBoxView.hh"
 #include "libmedia/mpeg4/box/MovieHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/SampleDependencyTypeBoxView.hh"
 #include "libmedia/mpeg4/box/SampleDescriptionBoxView.hh"
 #include "libmedia/mpeg4/box/SampleEntryBoxView.hh"
+#include "libmedia/mpeg4/box/SampleGroupDescriptionBoxView.hh"
 #include "libmedia/mpeg4/box/SampleSizeBoxView.hh"
+#include "libmedia/mpeg4/box/SampleToChunkBoxView.hh"
+#include "libmedia/mpeg4/box/SampleToGroupBoxView.hh"
+#include "libmedia/mpeg4/box/SegmentIndexBoxView.hh"
+#include "libmedia/mpeg4/box/SyncSampleBoxView.hh"
+#include "libmedia/mpeg4/box/TimeToSampleBoxView.hh"
+#include "libmedia/mpeg4/box/TrackExtendsBoxView.hh"
+#include "libmedia/mpeg4/box/TrackFragmentBaseMediaDecodeTimeBoxView.hh"
+#include "libmedia/mpeg4/box/TrackFragmentHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/TrackFragmentRandomAccessBoxView.hh"
 #include "libmedia/mpeg4/box/TrackHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/TrackRunBoxView.hh"
 
 namespace Mpeg4 {
 
@@ -458,6 +475,41 @@ inline std::string dump(const ChunkOffset64BoxView &co64_type_box)
     return std::format("{{large_chunk_offsets_size: {}}}", entry_count.value());
 }
 
+inline std::string dump(const EditListBoxView &elst_type_box)
+{
+    auto entry_count = elst_type_box.get_entry_count();
+
+    std::string error_message = "Mpeg4::dump(BoxViewEditList): ";
+    if (!entry_count) {
+        throw std::runtime_error(
+            error_message + "entry_count" + " parse failue");
+    }
+
+    std::string output = "{entries: [";
+
+    bool first = true;
+    for (uint32_t entry_idx = 0; entry_idx < entry_count.value();
+         entry_idx++) {
+        auto entry = elst_type_box.get_entry_unsafe(entry_idx);
+        if (!first) {
+            output.append(", ");
+        }
+        std::format_to(
+            std::back_inserter(output),
+            "{{segment_duration: {}, media_time: {}, media_rate_integer: {}, "
+            "media_rate_fraction: {}}}",
+            entry.segment_duration,
+            entry.media_time,
+            entry.media_rate_integer,
+            entry.media_rate_fraction);
+        first = false;
+    }
+
+    output.append("]}");
+
+    return output;
+}
+
 inline std::string dump(const SampleSizeBoxView &stsz_type_box)
 {
     auto samples_count = stsz_type_box.get_samples_count();
@@ -538,4 +590,345 @@ inline std::string dump(const SampleDescriptionBoxView &stsd_type_box)
     return output;
 }
 
+inline std::string dump(const TimeToSampleBoxView &stts_type_box)
+{
+    auto entry_count = stts_type_box.get_entry_count();
+
+    std::string error_message = "Mpeg4::dump(BoxViewTimeToSample): ";
+    if (!entry_count) {
+        throw std::runtime_error(
+            error_message + "entry_count" + " parse failue");
+    }
+
+    return std::format("{{entry_count: {}}}", entry_count.value());
+}
+
+inline std::string dump(const SampleToChunkBoxView &stsc_type_box)
+{
+    auto entry_count = stsc_type_box.get_entry_count();
+
+    std::string error_message = "Mpeg4::dump(BoxViewSampleToChunk): ";
+    if (!entry_count) {
+        throw std::runtime_error(
+            error_message + "entry_count" + " parse failue");
+    }
+
+    return std::format("{{entry_count: {}}}", entry_count.value());
+}
+
+inline std::string dump(const SyncSampleBoxView &stss_type_box)
+{
+    auto entry_count = stss_type_box.get_entry_count();
+
+    std::string error_message = "Mpeg4::dump(BoxViewSyncSample): ";
+    if (!entry_count) {
+        throw std::runtime_error(
+            error_message + "entry_count" + " parse failue");
+    }
+
+    return std::format("{{sync_samples_count: {}}}", entry_count.value());
+}
+
+inline std::string dump(const SampleDependencyTypeBoxView &sdtp_type_box)
+{
+    auto entry_count = sdtp_type_box.get_entry_count();
+
+    std::string error_message = "Mpeg4::dump(BoxViewSampleDependencyType): ";
+    if (!entry_count) {
+        throw std::runtime_error(
+            error_message + "entry_count" + " parse failue");
+    }
+
+    return std::format("{{samples_count: {}}}", entry_count.value());
+}
+
+inline std::string dump(const SampleToGroupBoxView &sbgp_type_box)
+{
+    auto grouping_type = sbgp_type_box.get_grouping_type();
+    auto entry_count = sbgp_type_box.get_entry_count();
+
+    std::string error_message = "Mpeg4::dump(BoxViewSampleToGroup): ";
+    if (!grouping_type) {
+        throw std::runtime_error(
+            error_message + "grouping_type" + " parse failue");
+    }
+
+    if (!entry_count) {
+        throw std::runtime_error(
+            error_message + "entry_count" + " parse failue");
+    }
+
+    return std::format(
+        "{{grouping_type: {}, entry_count: {}}}",
+        grouping_type.value(),
+        entry_count.value());
+}
+
+inline std::string dump(const SampleGroupDescriptionBoxView &sgpd_type_box)
+{
+    auto grouping_type = sgpd_type_box.get_grouping_type();
+    auto entry_count = sgpd_type_box.get_entry_count();
+
+    std::string error_message = "Mpeg4::dump(BoxViewSampleGroupDescription): ";
+    if (!grouping_type) {
+        throw std::runtime_error(
+            error_message + "grouping_type" + " parse failue");
+    }
+
+    if (!entry_count) {
+        throw std::runtime_error(
+            error_message + "entry_count" + " parse failue");
+    }
+
+    return std::format(
+        "{{grouping_type: {}, entry_count: {}}}",
+        grouping_type.value(),
+        entry_count.value());
+}
+
+inline std::string dump(const MovieFragmentHeaderBoxView &mfhd_type_box)
+{
+    auto sequence_number = mfhd_type_box.get_sequence_number();
+
+    std::string error_message = "Mpeg4::dump(BoxViewMovieFragmentHeader): ";
+    if (!sequence_number) {
+        throw std::runtime_error(
+            error_message + "sequence_number" + " parse failue");
+    }
+
+    return std::format("{{sequence_number: {}}}", sequence_number.value());
+}
+
+inline std::string dump(const TrackFragmentHeaderBoxView &tfhd_type_box)
+{
+    auto track_ID = tfhd_type_box.get_track_ID();
+    auto flags = tfhd_type_box.get_flags();
+
+    std::string error_message = "Mpeg4::dump(BoxViewTrackFragmentHeader): ";
+    if (!track_ID) {
+        throw std::runtime_error(error_message + "track_ID" + " parse failue");
+    }
+
+    if (!flags) {
+        throw std::runtime_error(error_message + "flags" + " parse failue");
+    }
+
+    auto dump_optional = [](auto value) -> std::string {
+        if (!value) {
+            return "none";
+        }
+        return std::to_string(value.value());
+    };
+
+    return std::format(
+        "{{track_ID: {}, base_data_offset: {}, "
+        "sample_description_index: {}, default_sample_duration: {}, "
+        "default_sample_size: {}, default_sample_flags: {}, "
+        "duration_is_empty: {}, default_base_is_moof: {}}}",
+        track_ID.value(),
+        dump_optional(tfhd_type_box.get_base_data_offset()),
+        dump_optional(tfhd_type_box.get_sample_description_index()),
+        dump_optional(tfhd_type_box.get_default_sample_duration()),
+        dump_optional(tfhd_type_box.get_default_sample_size()),
+        dump_optional(tfhd_type_box.get_default_sample_flags()),
+        (flags.value() & TrackFragmentHeaderBoxView::duration_is_empty) != 0,
+        (flags.value() & TrackFragmentHeaderBoxView::default_base_is_moof) !=
+            0);
+}
+
+inline std::string
+    dump(const TrackFragmentBaseMediaDecodeTimeBoxView &tfdt_type_box)
+{
+    auto base_media_decode_time = tfdt_type_box.get_base_media_decode_time();
+
+    std::string error_message =
+        "Mpeg4::dump(BoxViewTrackFragmentBaseMediaDecodeTime): ";
+    if (!base_media_decode_time) {
+        throw std::runtime_error(
+            error_message + "base_media_decode_time" + " parse failue");
+    }
+
+    return std::format(
+        "{{base_media_decode_time: {}}}", base_media_decode_time.value());
+}
+
+inline std::string dump(const TrackRunBoxView &trun_type_box)
+{
+    auto sample_count = trun_type_box.get_sample_count();
+
+    std::string error_message = "Mpeg4::dump(BoxViewTrackRun): ";
+    if (!sample_count) {
+        throw std::runtime_error(
+            error_message + "sample_count" + " parse failue");
+    }
+
+    auto dump_optional = [](auto value) -> std::string {
+        if (!value) {
+            return "none";
+        }
+        return std::to_string(value.value());
+    };
+
+    return std::format(
+        "{{sample_count: {}, data_offset: {}, first_sample_flags: {}}}",
+        sample_count.value(),
+        dump_optional(trun_type_box.get_data_offset()),
+        dump_optional(trun_type_box.get_first_sample_flags()));
+}
+
+inline std::string dump(const SegmentIndexBoxView &sidx_type_box)
+{
+    auto reference_ID = sidx_type_box.get_reference_ID();
+    auto timescale = sidx_type_box.get_timescale();
+    auto earliest_presentation_time =
+        sidx_type_box.get_earliest_presentation_time();
+    auto first_offset = sidx_type_box.get_first_offset();
+    auto reference_count = sidx_type_box.get_reference_count();
+
+    std::string error_message = "Mpeg4::dump(BoxViewSegmentIndex): ";
+    if (!reference_ID) {
+        throw std::runtime_error(
+            error_message + "reference_ID" + " parse failue");
+    }
+
+    if (!timescale) {
+        throw std::runtime_error(error_message + "timescale" + " parse failue");
+    }
+
+    if (!earliest_presentation_time) {
+        throw std::runtime_error(
+            error_message + "earliest_presentation_time" + " parse failue");
+    }
+
+    if (!first_offset) {
+        throw std::runtime_error(
+            error_message + "first_offset" + " parse failue");
+    }
+
+    if (!reference_count) {
+        throw std::runtime_error(
+            error_message + "reference_count" + " parse failue");
+    }
+
+    return std::format(
+        "{{reference_ID: {}, timescale: {}, earliest_presentation_time: {}, "
+        "first_offset: {}, reference_count: {}}}",
+        reference_ID.value(),
+        timescale.value(),
+        earliest_presentation_time.value(),
+        first_offset.value(),
+        reference_count.value());
+}
+
+inline std::string dump(const MovieFragmentRandomAccessBoxView &mfra_type_box)
+{
+    auto tfra_count = mfra_type_box.get_tfra_count();
+
+    std::string error_message =
+        "Mpeg4::dump(BoxViewMovieFragmentRandomAccess): ";
+    if (!tfra_count) {
+        throw std::runtime_error(
+            error_message + "tfra_count" + " parse failue");
+    }
+
+    return std::format("{{tfra_count: {}}}", tfra_count.value());
+}
+
+inline std::string
+    dump(const MovieFragmentRandomAccessOffsetBoxView &mfro_type_box)
+{
+    auto parent_size = mfro_type_box.get_parent_size();
+
+    std::string error_message =
+        "Mpeg4::dump(BoxViewMovieFragmentRandomAccessOffset): ";
+    if (!parent_size) {
+        throw std::runtime_error(
+            error_message + "parent_size" + " parse failue");
+    }
+
+    return std::format("{{parent_size: {}}}", parent_size.value());
+}
+
+inline std::string dump(const TrackFragmentRandomAccessBoxView &tfra_type_box)
+{
+    auto track_ID = tfra_type_box.get_track_ID();
+    auto entry_count = tfra_type_box.get_entry_count();
+
+    std::string error_message =
+        "Mpeg4::dump(BoxViewTrackFragmentRandomAccess): ";
+    if (!track_ID) {
+        throw std::runtime_error(error_message + "track_ID" + " parse failue");
+    }
+
+    if (!entry_count) {
+        throw std::runtime_error(
+            error_message + "entry_count" + " parse failue");
+    }
+
+    return std::format(
+        "{{track_ID: {}, entry_count: {}}}",
+        track_ID.value(),
+        entry_count.value());
+}
+
+inline std::string dump(const MovieExtendsHeaderBoxView &mehd_type_box)
+{
+    auto fragment_duration = mehd_type_box.get_fragment_duration();
+
+    std::string error_message = "Mpeg4::dump(BoxViewMovieExtendsHeader): ";
+    if (!fragment_duration) {
+        throw std::runtime_error(
+            error_message + "fragment_duration" + " parse failue");
+    }
+
+    return std::format(
+        "{{fragment_duration: {}}}", fragment_duration.value());
+}
+
+inline std::string dump(const TrackExtendsBoxView &trex_type_box)
+{
+    auto track_ID = trex_type_box.get_track_ID();
+    auto sample_description_index =
+        trex_type_box.get_default_sample_description_index();
+    auto sample_duration = trex_type_box.get_default_sample_duration();
+    auto sample_size = trex_type_box.get_default_sample_size();
+    auto sample_flags = trex_type_box.get_default_sample_flags();
+
+    std::string error_message = "Mpeg4::dump(BoxViewTrackExtends): ";
+    if (!track_ID) {
+        throw std::runtime_error(error_message + "track_ID" + " parse failue");
+    }
+
+    if (!sample_description_index) {
+        throw std::runtime_error(
+            error_message + "default_sample_description_index" +
+            " parse failue");
+    }
+
+    if (!sample_duration) {
+        throw std::runtime_error(
+            error_message + "default_sample_duration" + " parse failue");
+    }
+
+    if (!sample_size) {
+        throw std::runtime_error(
+            error_message + "default_sample_size" + " parse failue");
+    }
+
+    if (!sample_flags) {
+        throw std::runtime_error(
+            error_message + "default_sample_flags" + " parse failue");
+    }
+
+    return std::format(
+        "{{track_ID: {}, default_sample_description_index: {}, "
+        "default_sample_duration: {}, default_sample_size: {}, "
+        "default_sample_flags: {}}}",
+        track_ID.value(),
+        sample_description_index.value(),
+        sample_duration.value(),
+        sample_size.value(),
+        sample_flags.value());
+}
+
 } // namespace Mpeg4
@@ -0,0 +1,386 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4/box/EditListBoxView.hh"
+#include "libmedia/mpeg4/timescale.hh"
+
+namespace Mpeg4 {
+
+/*
+ * Maps presentation (movie) time to media time of one track
+ * according to its edit list (ISO/IEC 14496-12 8.6.6)
+ *
+ * Segment boundaries are precomputed so every lookup is a binary search
+ * over edits. Track without edits maps times one to one (only timescale
+ * conversion is applied)
+ */
+struct EditListTimeline
+{
+    static constexpr uint64_t infinite = std::numeric_limits<uint64_t>::max();
+
+    struct Segment
+    {
+        uint64_t movie_start;    // in movie timescale
+        uint64_t movie_duration; // in movie timescale, may be infinite
+        uint64_t media_start;    // in media timescale
+        uint64_t media_duration; // in media timescale, 0 for dwell
+        bool empty;
+        bool dwell;
+
+        constexpr uint64_t movie_end() const
+        {
+            if (movie_duration > infinite - movie_start) {
+                return infinite;
+            }
+            return movie_start + movie_duration;
+        }
+
+        constexpr uint64_t media_end() const
+        {
+            if (media_duration > infinite - media_start) {
+                return infinite;
+            }
+            return media_start + media_duration;
+        }
+    };
+
+    struct MappedInterval
+    {
+        uint64_t movie_begin;
+        uint64_t movie_end;
+        uint64_t media_begin;
+        uint64_t media_end; // equal to media_begin for dwell edits
+    };
+
+    constexpr EditListTimeline(
+        uint32_t movie_timescale,
+        uint32_t media_timescale)
+        : m_movie_timescale(movie_timescale), m_media_timescale(media_timescale)
+    {
+    }
+
+    static constexpr std::optional<EditListTimeline> from_box(
+        const EditListBoxView &elst,
+        uint32_t movie_timescale,
+        uint32_t media_timescale)
+    {
+        if (movie_timescale == 0 || media_timescale == 0) {
+            return std::nullopt;
+        }
+
+        auto entry_count = elst.get_entry_count();
+        if (!entry_count) {
+            return std::nullopt;
+        }
+
+        EditListTimeline output(movie_timescale, media_timescale);
+        output.m_segments.reserve(entry_count.value());
+
+        uint64_t movie_position = 0;
+        for (uint32_t entry_idx = 0; entry_idx < entry_count.value();
+             entry_idx++) {
+            auto entry = elst.get_entry_unsafe(entry_idx);
+            if (entry.media_time < -1) {
+                return std::nullopt;
+            }
+
+            Segment segment;
+            segment.movie_start = movie_position;
+            segment.movie_duration = entry.segment_duration;
+            segment.empty = entry.is_empty();
+            segment.dwell = !segment.empty && entry.is_dwell();
+            segment.media_start = segment.empty ? 0 : entry.media_time;
+            segment.media_duration = 0;
+
+            /*
+             * Zero duration of the last edit is used by fragmented files
+             * to say "the rest of the media"
+             */
+            bool is_last = entry_idx + 1 == entry_count.value();
+            if (is_last && !segment.empty && segment.movie_duration == 0) {
+                segment.movie_duration = infinite;
+            }
+
+            if (!segment.empty && !segment.dwell) {
+                segment.media_duration =
+                    segment.movie_duration == infinite
+                    ? infinite
+                    : output.movie_to_media_delta(segment.movie_duration);
+            }
+
+            movie_position = segment.movie_end();
+            output.m_segments.push_back(segment);
+        }
+
+        output.build_media_index();
+        return output;
+    }
+
+    constexpr bool has_edits() const
+    {
+        return !m_segments.empty();
+    }
+
+    constexpr std::span<const Segment> get_segments() const
+    {
+        return m_segments;
+    }
+
+    constexpr uint32_t get_movie_timescale() const
+    {
+        return m_movie_timescale;
+    }
+
+    constexpr uint32_t get_media_timescale() const
+    {
+        return m_media_timescale;
+    }
+
+    // Movie time of the end of the last edit
+    constexpr uint64_t get_movie_duration() const
+    {
+        if (m_segments.empty()) {
+            return infinite;
+        }
+        return m_segments.back().movie_end();
+    }
+
+    // std::nullopt if movie_time falls into an empty edit or past the edits
+    constexpr std::optional<uint64_t> movie_to_media(uint64_t movie_time) const
+    {
+        if (m_segments.empty()) {
+            return movie_to_media_delta(movie_time);
+        }
+
+        auto segment = find_movie_segment(movie_time);
+        if (!segment || segment->empty) {
+            return std::nullopt;
+        }
+
+        if (segment->dwell) {
+            return segment->media_start;
+        }
+
+        return segment->media_start +
+            movie_to_media_delta(movie_time - segment->movie_start);
+    }
+
+    // Earliest movie time at which media_time is presented
+    constexpr std::optional<uint64_t> media_to_movie(uint64_t media_time) const
+    {
+        if (m_segments.empty()) {
+            return media_to_movie_delta(media_time);
+        }
+        // elst media_time is signed, no edit starts at or reaches infinite
+        if (media_time == infinite) {
+            return std::nullopt;
+        }
+
+        auto intervals = map_media_interval(media_time, media_time + 1);
+        if (intervals.empty()) {
+            return std::nullopt;
+        }
+
+        return intervals.front().movie_begin;
+    }
+
+    /*
+     * Splits movie interval [movie_begin, movie_end) into pieces of media
+     * presented by edits, ordered by movie time. Empty edits produce
+     * no pieces
+     */
+    constexpr std::vector<MappedInterval>
+        map_movie_interval(uint64_t movie_begin, uint64_t movie_end) const
+    {
+        std::vector<MappedInterval> output;
+        if (movie_begin >= movie_end) {
+            return output;
+        }
+
+        if (m_segments.empty()) {
+            output.emplace_back(
+                movie_begin,
+                movie_end,
+                movie_to_media_delta(movie_begin),
+                movie_to_media_delta(movie_end));
+            return output;
+        }
+
+        auto segment_it = std::ranges::upper_bound(
+            m_segments, movie_begin, {}, &Segment::movie_start);
+        if (segment_it != std::begin(m_segments)) {
+            segment_it--;
+        }
+
+        for (; segment_it != std::end(m_segments) &&
+             segment_it->movie_start < movie_end;
+             segment_it++) {
+            auto &segment = *segment_it;
+
+            uint64_t begin = std::max(movie_begin, segment.movie_start);
+            uint64_t end = std::min(movie_end, segment.movie_end());
+            if (begin >= end || segment.empty) {
+                continue;
+            }
+
+            if (segment.dwell) {
+                output.emplace_back(
+                    begin, end, segment.media_start, segment.media_start);
+                continue;
+            }
+
+            output.emplace_back(
+                begin,
+                end,
+                segment.media_start +
+                    movie_to_media_delta(begin - segment.movie_start),
+                segment.media_start +
+                    movie_to_media_delta(end - segment.movie_start));
+        }
+
+        return output;
+    }
+
+    /*
+     * Finds every place where media interval [media_begin, media_end)
+     * is presented, ordered by movie time
+     */
+    constexpr std::vector<MappedInterval>
+        map_media_interval(uint64_t media_begin, uint64_t media_end) const
+    {
+        std::vector<MappedInterval> output;
+        if (media_begin >= media_end) {
+            return output;
+        }
+
+        if (m_segments.empty()) {
+            output.emplace_back(
+                media_to_movie_delta(media_begin),
+                media_to_movie_delta(media_end),
+                media_begin,
+                media_end);
+            return output;
+        }
+
+        /*
+         * Segments sorted by media_start, only a prefix of them may start
+         * before media_end, and scan back stops as soon as none of
+         * remaining segments reaches media_begin
+         */
+        auto candidates_end = std::ranges::upper_bound(
+            m_media_order,
+            media_end - 1,
+            {},
+            [this](uint32_t idx) { return m_segments[idx].media_start; });
+        size_t candidate =
+            std::distance(std::begin(m_media_order), candidates_end);
+
+        while (candidate > 0 &&
+               m_media_order_max_end[candidate - 1] > media_begin) {
+            candidate--;
+            auto &segment = m_segments[m_media_order[candidate]];
+
+            if (segment.dwell) {
+                if (segment.media_start < media_begin) {
+                    continue;
+                }
+                output.emplace_back(
+                    segment.movie_start,
+                    segment.movie_end(),
+                    segment.media_start,
+                    segment.media_start);
+                continue;
+            }
+
+            uint64_t begin = std::max(media_begin, segment.media_start);
+            uint64_t end = std::min(media_end, segment.media_end());
+            if (begin >= end) {
+                continue;
+            }
+
+            uint64_t movie_end =
+                segment.movie_start +
+                media_to_movie_delta(end - segment.media_start);
+            output.emplace_back(
+                segment.movie_start +
+                    media_to_movie_delta(begin - segment.media_start),
+                std::min(movie_end, segment.movie_end()),
+                begin,
+                end);
+        }
+
+        std::ranges::sort(output, {}, &MappedInterval::movie_begin);
+        return output;
+    }
+
+  private:
+    uint32_t m_movie_timescale;
+    uint32_t m_media_timescale;
+    std::vector<Segment> m_segments;
+
+    // Indices of non-empty segments sorted by media_start
+    std::vector<uint32_t> m_media_order;
+    // Running max of media_end (dwell covers single tick) over m_media_order
+    std::vector<uint64_t> m_media_order_max_end;
+
+    constexpr uint64_t movie_to_media_delta(uint64_t movie_delta) const
+    {
+        return rescale_time(movie_delta, m_movie_timescale, m_media_timescale);
+    }
+
+    constexpr uint64_t media_to_movie_delta(uint64_t media_delta) const
+    {
+        return rescale_time(media_delta, m_media_timescale, m_movie_timescale);
+    }
+
+    constexpr const Segment *find_movie_segment(uint64_t movie_time) const
+    {
+        auto segment_it = std::ranges::upper_bound(
+            m_segments, movie_time, {}, &Segment::movie_start);
+        if (segment_it == std::begin(m_segments)) {
+            return nullptr;
+        }
+        segment_it--;
+
+        if (movie_time >= segment_it->movie_end()) {
+            return nullptr;
+        }
+        return &*segment_it;
+    }
+
+    constexpr void build_media_index()
+    {
+        m_media_order.clear();
+        for (uint32_t idx = 0; idx < m_segments.size(); idx++) {
+            if (!m_segments[idx].empty) {
+                m_media_order.push_back(idx);
+            }
+        }
+
+        // Ties keep edit order, as stable_sort would (not constexpr)
+        std::ranges::sort(m_media_order, {}, [this](uint32_t idx) {
+            return std::pair(m_segments[idx].media_start, idx);
+        });
+
+        m_media_order_max_end.resize(m_media_order.size());
+        uint64_t max_end = 0;
+        for (size_t pos = 0; pos < m_media_order.size(); pos++) {
+            auto &segment = m_segments[m_media_order[pos]];
+            uint64_t end = segment.dwell ? segment.media_start + 1
+                                         : segment.media_end();
+            max_end = std::max(max_end, end);
+            m_media_order_max_end[pos] = max_end;
+        }
+    }
+};
+
+} // namespace Mpeg4
@@ -0,0 +1,433 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/executor.hh"
+#include "libmedia/mpeg4.hh"
+#include "libmedia/mpeg4/box_sequence.hh"
+#include "libmedia/mpeg4/sample_index.hh"
+#include "libmedia/mpeg4/track_extends.hh"
+
+#include "libmedia/mpeg4/box/MovieFragmentHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/TrackFragmentBaseMediaDecodeTimeBoxView.hh"
+#include "libmedia/mpeg4/box/TrackFragmentHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/TrackRunBoxView.hh"
+
+namespace Mpeg4 {
+
+// ISO/IEC 14496-12 8.8.3.1 sample_is_non_sync_sample bit of sample flags
+constexpr uint32_t sample_is_non_sync_sample = 0x00010000;
+
+struct FragmentSample
+{
+    uint64_t offset;
+    uint32_t size;
+    uint64_t dts;
+    uint32_t duration;
+    int64_t composition_offset;
+    bool is_sync;
+};
+
+// Samples of one traf, dts relative to the start of the fragment
+struct TrackFragmentSamples
+{
+    uint32_t track_ID;
+    std::optional<uint64_t> base_media_decode_time; // from tfdt
+    uint64_t duration;
+    std::vector<FragmentSample> samples;
+};
+
+/*
+ * Samples of all trafs of one moof with absolute file offsets
+ *
+ * Fields missing from trun are taken from tfhd defaults, then from trex
+ * defaults of the track (resolved once per traf)
+ */
+struct MovieFragment
+{
+    uint64_t moof_offset;
+    uint32_t sequence_number;
+    std::vector<TrackFragmentSamples> tracks;
+
+    static std::optional<MovieFragment> parse(
+        BoxView moof,
+        uint64_t moof_offset,
+        const TrackExtends &track_extends = {})
+    {
+        constexpr TypeTag moof_tag = TypeTag::from_str("moof");
+        constexpr TypeTag traf_tag = TypeTag::from_str("traf");
+
+        auto header = moof.get_header();
+        auto content = moof.get_content_data();
+        if (!header || !content || header->type != moof_tag) {
+            return std::nullopt;
+        }
+
+        MovieFragment output;
+        output.moof_offset = moof_offset;
+        output.sequence_number = 0;
+
+        uint64_t previous_data_end = moof_offset;
+
+        BoxSequence children(content.value());
+        while (auto child = children.next()) {
+            auto type = child->get_header()->type;
+
+            MovieFragmentHeaderBoxView mfhd(child.value());
+            if (mfhd.is_valid()) {
+                output.sequence_number = mfhd.get_sequence_number().value();
+                continue;
+            }
+
+            if (type != traf_tag) {
+                continue;
+            }
+
+            bool is_first_traf = output.tracks.empty();
+            auto track = parse_traf(
+                child.value(),
+                moof_offset,
+                track_extends,
+                is_first_traf,
+                previous_data_end);
+            if (!track) {
+                return std::nullopt;
+            }
+            output.tracks.push_back(std::move(track.value()));
+        }
+
+        return output;
+    }
+
+  private:
+    static std::optional<TrackFragmentSamples> parse_traf(
+        BoxView traf,
+        uint64_t moof_offset,
+        const TrackExtends &track_extends,
+        bool is_first_traf,
+        uint64_t &previous_data_end)
+    {
+        auto traf_data = traf.get_content_data().value();
+
+        auto tfhd_box =
+            find_box(traf_data, TrackFragmentHeaderBoxView::tfhd_tag);
+        if (!tfhd_box) {
+            return std::nullopt;
+        }
+        TrackFragmentHeaderBoxView tfhd(tfhd_box.value());
+        auto flags = tfhd.get_flags();
+        if (!flags) {
+            return std::nullopt;
+        }
+
+        TrackFragmentSamples output;
+        output.track_ID = tfhd.get_track_ID().value();
+        output.duration = 0;
+
+        auto tfdt_box = find_box(
+            traf_data, TrackFragmentBaseMediaDecodeTimeBoxView::tfdt_tag);
+        if (tfdt_box) {
+            output.base_media_decode_time =
+                TrackFragmentBaseMediaDecodeTimeBoxView(tfdt_box.value())
+                    .get_base_media_decode_time();
+        }
+
+        /*
+         * ISO/IEC 14496-12 8.8.7.1
+         * Without explicit base_data_offset data of the first traf starts
+         * at moof, data of next ones continues after the previous traf
+         * unless default-base-is-moof is set
+         */
+        constexpr uint32_t base_is_moof =
+            TrackFragmentHeaderBoxView::default_base_is_moof;
+        uint64_t base_offset = previous_data_end;
+        if (auto offset = tfhd.get_base_data_offset()) {
+            base_offset = offset.value();
+        } else if (is_first_traf || (flags.value() & base_is_moof) != 0) {
+            base_offset = moof_offset;
+        }
+
+        SampleDefaults sample_defaults = track_extends.resolve(tfhd);
+        TrackRunBoxView::Entry defaults{
+            sample_defaults.sample_duration,
+            sample_defaults.sample_size,
+            sample_defaults.sample_flags,
+            0};
+
+        uint64_t data_cursor = base_offset;
+        BoxSequence children(traf_data);
+        while (auto child = children.next()) {
+            TrackRunBoxView trun(child.value());
+            if (trun.is_not_valid()) {
+                continue;
+            }
+
+            if (auto data_offset = trun.get_data_offset()) {
+                data_cursor = base_offset + data_offset.value();
+            }
+
+            append_run(output, trun, defaults, data_cursor);
+        }
+
+        previous_data_end = data_cursor;
+        return output;
+    }
+
+    static void append_run(
+        TrackFragmentSamples &output,
+        const TrackRunBoxView &trun,
+        const TrackRunBoxView::Entry &defaults,
+        uint64_t &data_cursor)
+    {
+        constexpr uint32_t batch_size = 256;
+        std::array<TrackRunBoxView::Entry, batch_size> entries;
+
+        uint32_t sample_count = trun.get_sample_count().value();
+
+        for (uint32_t first = 0; first < sample_count; first += batch_size) {
+            uint32_t count = trun.decode_entries(first, entries, defaults);
+            for (auto &entry : std::span(entries).subspan(0, count)) {
+                FragmentSample sample;
+                sample.offset = data_cursor;
+                sample.size = entry.sample_size;
+                sample.dts = output.duration;
+                sample.duration = entry.sample_duration;
+                sample.composition_offset =
+                    entry.sample_composition_time_offset;
+                sample.is_sync =
+                    (entry.sample_flags & sample_is_non_sync_sample) == 0;
+                output.samples.push_back(sample);
+
+                data_cursor += entry.sample_size;
+                output.duration += entry.sample_duration;
+            }
+        }
+    }
+};
+
+/*
+ * Samples of one track collected from consecutive fragments
+ *
+ * Decode times continue from the previous fragment when a fragment
+ * has no tfdt
+ */
+struct FragmentedTrack
+{
+    using Sample = FragmentSample;
+
+    FragmentedTrack(uint32_t track_ID) : m_track_ID(track_ID)
+    {
+    }
+
+    uint32_t get_track_ID() const
+    {
+        return m_track_ID;
+    }
+
+    uint32_t get_sample_count() const
+    {
+        return m_samples.size();
+    }
+
+    // Decode time where the last sample ends
+    uint64_t get_duration() const
+    {
+        return m_end_dts;
+    }
+
+    std::optional<Sample> get_sample(uint32_t sample_index) const
+    {
+        if (sample_index >= m_samples.size()) {
+            return std::nullopt;
+        }
+        return m_samples[sample_index];
+    }
+
+    Sample get_sample_unsafe(uint32_t sample_index) const
+    {
+        return m_samples[sample_index];
+    }
+
+    // Sample being decoded at dts
+    std::optional<uint32_t> find_sample_at_time(uint64_t dts) const
+    {
+        if (m_samples.empty() || dts < m_samples.front().dts ||
+            dts >= m_end_dts) {
+            return std::nullopt;
+        }
+
+        auto next =
+            std::ranges::upper_bound(m_samples, dts, {}, &Sample::dts);
+        return std::distance(std::begin(m_samples), next) - 1;
+    }
+
+    // Last sync sample at or before sample_index
+    std::optional<uint32_t>
+        find_sync_sample_before(uint32_t sample_index) const
+    {
+        if (sample_index >= m_samples.size()) {
+            return std::nullopt;
+        }
+
+        auto sync_it = std::ranges::upper_bound(m_sync_samples, sample_index);
+        if (sync_it == std::begin(m_sync_samples)) {
+            return std::nullopt;
+        }
+        return *std::prev(sync_it);
+    }
+
+    void append(const TrackFragmentSamples &fragment)
+    {
+        uint64_t base_dts =
+            fragment.base_media_decode_time.value_or(m_end_dts);
+
+        for (auto sample : fragment.samples) {
+            sample.dts += base_dts;
+            if (sample.is_sync) {
+                m_sync_samples.push_back(m_samples.size());
+            }
+            m_samples.push_back(sample);
+        }
+        m_end_dts = base_dts + fragment.duration;
+    }
+
+  private:
+    uint32_t m_track_ID;
+    uint64_t m_end_dts = 0;
+    std::vector<Sample> m_samples;
+    std::vector<uint32_t> m_sync_samples;
+};
+
+static_assert(SampleIndex<FragmentedTrack>);
+
+// Fragments of a file and samples of their tracks, appended in file order
+struct FragmentIndex
+{
+    struct Fragment
+    {
+        uint64_t moof_offset;
+        uint32_t sequence_number;
+    };
+
+    void append(const MovieFragment &fragment)
+    {
+        m_fragments.emplace_back(
+            fragment.moof_offset, fragment.sequence_number);
+
+        for (auto &track_fragment : fragment.tracks) {
+            auto track = std::ranges::find(
+                m_tracks,
+                track_fragment.track_ID,
+                &FragmentedTrack::get_track_ID);
+            if (track == std::end(m_tracks)) {
+                m_tracks.emplace_back(track_fragment.track_ID);
+                track = std::prev(std::end(m_tracks));
+            }
+            track->append(track_fragment);
+        }
+    }
+
+    uint32_t get_fragment_count() const
+    {
+        return m_fragments.size();
+    }
+
+    std::optional<Fragment> get_fragment(uint32_t fragment_index) const
+    {
+        if (fragment_index >= m_fragments.size()) {
+            return std::nullopt;
+        }
+        return m_fragments[fragment_index];
+    }
+
+    std::span<const FragmentedTrack> get_tracks() const
+    {
+        return m_tracks;
+    }
+
+    // Pointer is invalidated by the next append()
+    const FragmentedTrack *find_track(uint32_t track_ID) const
+    {
+        auto track = std::ranges::find(
+            m_tracks, track_ID, &FragmentedTrack::get_track_ID);
+        if (track == std::end(m_tracks)) {
+            return nullptr;
+        }
+        return &*track;
+    }
+
+  private:
+    std::vector<Fragment> m_fragments;
+    std::vector<FragmentedTrack> m_tracks;
+};
+
+/*
+ * Indexes all fragments of a complete file
+ *
+ * Top level boxes are scanned for moof offsets first, then fragments are
+ * parsed on executor in batches of batch_fragments and appended in file
+ * order, where decode times of fragments without tfdt are resolved from
+ * the previous ones. Returns nullopt if a moof is malformed
+ */
+template <Executor E>
+std::optional<FragmentIndex> build_fragment_index(
+    std::span<const std::byte> file,
+    E &executor,
+    size_t batch_fragments = 4096)
+{
+    constexpr TypeTag moof_tag = TypeTag::from_str("moof");
+    constexpr TypeTag moov_tag = TypeTag::from_str("moov");
+    constexpr size_t fragments_per_task = 64;
+    batch_fragments = std::max<size_t>(1, batch_fragments);
+
+    std::vector<size_t> moof_offsets;
+    TrackExtends track_extends;
+    BoxSequence boxes(file);
+    while (auto box = boxes.next()) {
+        auto type = box->get_header()->type;
+        if (type == moof_tag) {
+            moof_offsets.push_back(boxes.get_current_offset());
+        } else if (type == moov_tag) {
+            track_extends = TrackExtends::from_moov(box.value());
+        }
+    }
+
+    FragmentIndex output;
+    std::vector<std::optional<MovieFragment>> fragments;
+    for (size_t first = 0; first < moof_offsets.size();
+         first += batch_fragments) {
+        auto batch = std::span(moof_offsets).subspan(first);
+        batch = batch.subspan(0, std::min(batch.size(), batch_fragments));
+
+        fragments.assign(batch.size(), std::nullopt);
+        size_t task_count =
+            (batch.size() + fragments_per_task - 1) / fragments_per_task;
+        parallel_for(executor, task_count, [&](size_t task_idx) {
+            size_t begin = task_idx * fragments_per_task;
+            size_t end = std::min(begin + fragments_per_task, batch.size());
+            for (size_t idx = begin; idx < end; idx++) {
+                BoxView moof(file.subspan(batch[idx]));
+                fragments[idx] =
+                    MovieFragment::parse(moof, batch[idx], track_extends);
+            }
+        });
+
+        for (auto &fragment : fragments) {
+            if (!fragment) {
+                return std::nullopt;
+            }
+            output.append(fragment.value());
+        }
+    }
+
+    return output;
+}
+
+} // namespace Mpeg4
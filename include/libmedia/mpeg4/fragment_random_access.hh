@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+
+#include "libmedia/mpeg4/box/MovieFragmentRandomAccessBoxView.hh"
+#include "libmedia/mpeg4/box/MovieFragmentRandomAccessOffsetBoxView.hh"
+#include "libmedia/mpeg4/box/TrackFragmentRandomAccessBoxView.hh"
+
+namespace Mpeg4 {
+
+/*
+ * Time to moof lookup of a fragmented file built from mfra
+ *
+ * open() reads mfro from the last 16 bytes of the file and then mfra
+ * it points to: two reads regardless of the number of fragments
+ */
+struct FragmentRandomAccess
+{
+    using Entry = TrackFragmentRandomAccessBoxView::Entry;
+
+    /*
+     * fetch(offset, size) returns exactly size bytes of the file
+     * starting at offset or std::nullopt
+     */
+    template <typename Fetch>
+        requires std::invocable<Fetch &, uint64_t, uint64_t>
+    static std::optional<FragmentRandomAccess>
+        open(uint64_t file_size, Fetch &&fetch)
+    {
+        using MfroView = MovieFragmentRandomAccessOffsetBoxView;
+        if (file_size < MfroView::box_size) {
+            return std::nullopt;
+        }
+
+        std::optional<std::span<const std::byte>> mfro_data =
+            fetch(file_size - MfroView::box_size, MfroView::box_size);
+        if (!mfro_data) {
+            return std::nullopt;
+        }
+
+        auto mfra_size = MfroView(BoxView(mfro_data.value())).get_parent_size();
+        if (!mfra_size || mfra_size.value() > file_size ||
+            mfra_size.value() < MfroView::box_size) {
+            return std::nullopt;
+        }
+
+        std::optional<std::span<const std::byte>> mfra_data =
+            fetch(file_size - mfra_size.value(), mfra_size.value());
+        if (!mfra_data) {
+            return std::nullopt;
+        }
+
+        return from_mfra(BoxView(mfra_data.value()));
+    }
+
+    // file holds the whole file, e.g. FileView mapping
+    static std::optional<FragmentRandomAccess>
+        open(std::span<const std::byte> file)
+    {
+        auto fetch = [file](uint64_t offset, uint64_t size) {
+            return std::optional(file.subspan(offset, size));
+        };
+        return open(file.size(), fetch);
+    }
+
+    static std::optional<FragmentRandomAccess> from_mfra(BoxView mfra)
+    {
+        MovieFragmentRandomAccessBoxView mfra_view(mfra);
+        auto tfra_count = mfra_view.get_tfra_count();
+        if (!tfra_count) {
+            return std::nullopt;
+        }
+
+        FragmentRandomAccess output;
+        for (uint32_t tfra_idx = 0; tfra_idx < tfra_count.value();
+             tfra_idx++) {
+            auto tfra = mfra_view.get_tfra(tfra_idx).value();
+
+            Track track;
+            track.track_ID = tfra.get_track_ID().value();
+
+            uint32_t entry_count = tfra.get_entry_count().value();
+            track.entries.reserve(entry_count);
+            for (uint32_t entry_idx = 0; entry_idx < entry_count;
+                 entry_idx++) {
+                track.entries.push_back(tfra.get_entry_unsafe(entry_idx));
+            }
+
+            // Entries are required to be in time order, do not trust it
+            std::ranges::stable_sort(track.entries, {}, &Entry::time);
+            output.m_tracks.push_back(std::move(track));
+        }
+
+        return output;
+    }
+
+    std::vector<uint32_t> get_track_IDs() const
+    {
+        std::vector<uint32_t> output;
+        for (auto &track : m_tracks) {
+            output.push_back(track.track_ID);
+        }
+        return output;
+    }
+
+    /*
+     * Random access point of track at or before time
+     * (in track media timescale), moof_offset is the place to start
+     * parsing fragments from
+     */
+    std::optional<Entry> find_entry(uint32_t track_ID, uint64_t time) const
+    {
+        auto track = std::ranges::find(m_tracks, track_ID, &Track::track_ID);
+        if (track == std::end(m_tracks)) {
+            return std::nullopt;
+        }
+
+        auto &entries = track->entries;
+        auto next = std::ranges::upper_bound(entries, time, {}, &Entry::time);
+        if (next == std::begin(entries)) {
+            return std::nullopt;
+        }
+        return *std::prev(next);
+    }
+
+  private:
+    struct Track
+    {
+        uint32_t track_ID;
+        std::vector<Entry> entries;
+    };
+
+    std::vector<Track> m_tracks;
+
+    FragmentRandomAccess() = default;
+};
+
+} // namespace Mpeg4
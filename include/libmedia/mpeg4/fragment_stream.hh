@@ -0,0 +1,85 @@
+#pragma once
+
+#include <concepts>
+#include <expected>
+#include <span>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+#include "libmedia/mpeg4/box_sequence.hh"
+#include "libmedia/mpeg4/fragment_index.hh"
+#include "libmedia/mpeg4/track_extends.hh"
+
+namespace Mpeg4 {
+
+enum class FragmentStreamError
+{
+    INVALID_FRAGMENT,
+};
+
+constexpr uint64_t default_release_granularity = 8 * 1024 * 1024;
+
+/*
+ * Calls callback(fragment) for every moof of file in order, holding the
+ * metadata of one fragment at a time, returns the number of fragments.
+ * trex defaults are taken from moov preceding the fragments
+ *
+ * File bytes already walked past are passed to release(offset, size) in
+ * ranges of at least release_granularity bytes, so a mapped file can drop
+ * its pages (FileView::release) and resident memory stays flat. A range is
+ * released only after the box after it is reached, so sample data of a
+ * fragment (its mdat) is readable inside the callback, not after it
+ */
+template <typename Callback, typename Release>
+    requires std::invocable<Callback &, const MovieFragment &> &&
+             std::invocable<Release &, uint64_t, uint64_t>
+std::expected<uint32_t, FragmentStreamError> stream_fragments(
+    std::span<const std::byte> file,
+    Callback &&callback,
+    Release &&release,
+    uint64_t release_granularity = default_release_granularity)
+{
+    constexpr TypeTag moof_tag = TypeTag::from_str("moof");
+    constexpr TypeTag moov_tag = TypeTag::from_str("moov");
+
+    TrackExtends track_extends;
+    uint32_t fragment_count = 0;
+    uint64_t released_end = 0;
+
+    BoxSequence boxes(file);
+    while (auto box = boxes.next()) {
+        uint64_t box_offset = boxes.get_current_offset();
+
+        if (box_offset - released_end >= release_granularity) {
+            release(released_end, box_offset - released_end);
+            released_end = box_offset;
+        }
+
+        auto type = box->get_header()->type;
+        if (type == moov_tag) {
+            track_extends = TrackExtends::from_moov(box.value());
+            continue;
+        }
+        if (type != moof_tag) {
+            continue;
+        }
+
+        auto fragment =
+            MovieFragment::parse(box.value(), box_offset, track_extends);
+        if (!fragment) {
+            return std::unexpected(FragmentStreamError::INVALID_FRAGMENT);
+        }
+        callback(fragment.value());
+        fragment_count++;
+    }
+
+    if (boxes.get_position() > released_end) {
+        release(released_end, boxes.get_position() - released_end);
+    }
+
+    return fragment_count;
+}
+
+} // namespace Mpeg4
@@ -0,0 +1,484 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+#include "libmedia/mpeg4/box_sequence.hh"
+#include "libmedia/mpeg4/fragment_index.hh"
+#include "libmedia/mpeg4/fragment_random_access.hh"
+#include "libmedia/mpeg4/track_extends.hh"
+
+#include "libmedia/mpeg4/box/MediaHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/TrackHeaderBoxView.hh"
+
+namespace Mpeg4 {
+
+/*
+ * Duration of a fragmented file read from its tail
+ *
+ * Boxes before the first moof are read for moov (timescales and trex
+ * defaults). The last fragments are then found through mfra or, without
+ * it, by scanning backwards through the last bytes of the file for a
+ * moof, and their tfdt plus trun durations give track end times. Only if
+ * the tail is unusable (no moof found, fragments without tfdt) every
+ * moof is read in a forward scan
+ */
+struct FragmentedDuration
+{
+    enum class Source
+    {
+        MFRA,
+        TAIL_SCAN,
+        FORWARD_SCAN,
+    };
+
+    struct Track
+    {
+        uint32_t track_ID;
+        uint64_t end_time; // end of the last sample, in media timescale
+        std::optional<uint32_t> timescale; // from mdhd of moov
+    };
+
+    constexpr static uint64_t default_tail_size = 64 * 1024;
+    constexpr static uint64_t default_max_tail_size = 16 * 1024 * 1024;
+
+    Source source;
+    /*
+     * Exact for FORWARD_SCAN, otherwise derived from sequence numbers
+     * of the first and last moof (consecutive in practice)
+     */
+    uint32_t fragment_count;
+    std::vector<Track> tracks;
+    uint64_t bytes_read;
+
+    // Longest track, in seconds
+    std::optional<double> get_duration_seconds() const
+    {
+        std::optional<double> output;
+        for (auto &track : tracks) {
+            if (!track.timescale || track.timescale.value() == 0) {
+                continue;
+            }
+            double seconds = double(track.end_time) / track.timescale.value();
+            output = std::max(output.value_or(0), seconds);
+        }
+        return output;
+    }
+
+    /*
+     * fetch(offset, size) returns exactly size bytes of the file
+     * starting at offset or std::nullopt, the bytes may be invalidated
+     * by the next call. Tail window grows from tail_size up to
+     * max_tail_size while no usable moof is found in it
+     */
+    template <typename Fetch>
+        requires std::invocable<Fetch &, uint64_t, uint64_t>
+    static std::optional<FragmentedDuration> probe(
+        uint64_t file_size,
+        Fetch &&fetch,
+        uint64_t tail_size = default_tail_size,
+        uint64_t max_tail_size = default_max_tail_size)
+    {
+        Reader<Fetch> reader{file_size, fetch};
+
+        auto head = read_head(reader);
+        if (!head) {
+            return std::nullopt;
+        }
+
+        std::optional<FragmentedDuration> output =
+            probe_mfra(reader, head.value());
+        if (!output) {
+            output = probe_tail(reader, head.value(), tail_size, max_tail_size);
+        }
+        if (!output) {
+            output = walk_fragments(reader, head.value(), head->first_moof);
+            if (output) {
+                output->source = Source::FORWARD_SCAN;
+            }
+        }
+        if (!output) {
+            return std::nullopt;
+        }
+
+        for (auto &track : output->tracks) {
+            auto timescale = std::ranges::find(
+                head->timescales, track.track_ID, &TrackTimescale::track_ID);
+            if (timescale != std::end(head->timescales)) {
+                track.timescale = timescale->timescale;
+            }
+        }
+        output->bytes_read = reader.bytes_read;
+        return output;
+    }
+
+    // file holds the whole file, e.g. FileView mapping
+    static std::optional<FragmentedDuration>
+        probe(std::span<const std::byte> file)
+    {
+        auto fetch = [file](uint64_t offset, uint64_t size) {
+            return std::optional(file.subspan(offset, size));
+        };
+        return probe(file.size(), fetch);
+    }
+
+  private:
+    constexpr static TypeTag moof_tag = TypeTag::from_str("moof");
+    constexpr static TypeTag moov_tag = TypeTag::from_str("moov");
+    constexpr static TypeTag mfhd_tag = TypeTag::from_str("mfhd");
+
+    // size, type, largesize
+    constexpr static uint64_t max_plain_header_size = 16;
+
+    template <typename Fetch>
+    struct Reader
+    {
+        uint64_t file_size;
+        Fetch &fetch;
+        uint64_t bytes_read = 0;
+
+        std::optional<std::span<const std::byte>>
+            read(uint64_t offset, uint64_t size)
+        {
+            if (offset > file_size || size > file_size - offset) {
+                return std::nullopt;
+            }
+            std::optional<std::span<const std::byte>> data =
+                fetch(offset, size);
+            if (data) {
+                bytes_read += size;
+            }
+            return data;
+        }
+
+        // Type and full size of box at offset
+        std::optional<std::pair<TypeTag, uint64_t>>
+            read_header(uint64_t offset)
+        {
+            if (offset >= file_size) {
+                return std::nullopt;
+            }
+            uint64_t size =
+                std::min(max_plain_header_size, file_size - offset);
+            auto data = read(offset, size);
+            if (!data) {
+                return std::nullopt;
+            }
+
+            auto header = BoxView(data.value()).get_header();
+            if (!header || !header->box_content_size) {
+                return std::nullopt;
+            }
+            uint64_t box_size =
+                header->header_size + header->box_content_size.value();
+            if (box_size > file_size - offset) {
+                return std::nullopt;
+            }
+            return std::pair(header->type, box_size);
+        }
+    };
+
+    struct TrackTimescale
+    {
+        uint32_t track_ID;
+        uint32_t timescale;
+    };
+
+    struct Head
+    {
+        TrackExtends track_extends;
+        std::vector<TrackTimescale> timescales;
+        uint64_t first_moof;
+        uint32_t first_sequence_number;
+    };
+
+    template <typename Fetch>
+    static std::optional<Head> read_head(Reader<Fetch> &reader)
+    {
+        Head output;
+
+        uint64_t offset = 0;
+        while (auto header = reader.read_header(offset)) {
+            auto [type, box_size] = header.value();
+
+            if (type == moov_tag) {
+                auto moov = reader.read(offset, box_size);
+                if (moov) {
+                    output.track_extends =
+                        TrackExtends::from_moov(BoxView(moov.value()));
+                    output.timescales = read_timescales(BoxView(moov.value()));
+                }
+            }
+
+            if (type == moof_tag) {
+                auto moof = reader.read(offset, box_size);
+                if (!moof) {
+                    return std::nullopt;
+                }
+                auto fragment = MovieFragment::parse(
+                    BoxView(moof.value()), offset, output.track_extends);
+                if (!fragment) {
+                    return std::nullopt;
+                }
+
+                output.first_moof = offset;
+                output.first_sequence_number = fragment->sequence_number;
+                return output;
+            }
+
+            offset += box_size;
+        }
+
+        // Not a fragmented file
+        return std::nullopt;
+    }
+
+    static std::vector<TrackTimescale> read_timescales(BoxView moov)
+    {
+        constexpr TypeTag trak_tag = TypeTag::from_str("trak");
+        constexpr TypeTag tkhd_tag = TypeTag::from_str("tkhd");
+        constexpr TypeTag mdia_tag = TypeTag::from_str("mdia");
+        constexpr TypeTag mdhd_tag = TypeTag::from_str("mdhd");
+
+        std::vector<TrackTimescale> output;
+
+        BoxSequence children(moov.get_content_data().value());
+        while (auto child = children.next()) {
+            if (child->get_header()->type != trak_tag) {
+                continue;
+            }
+
+            auto trak_data = child->get_content_data().value();
+            auto tkhd = find_box(trak_data, {tkhd_tag});
+            auto mdhd = find_box(trak_data, {mdia_tag, mdhd_tag});
+            if (!tkhd || !mdhd) {
+                continue;
+            }
+
+            auto track_ID = TrackHeaderBoxView(tkhd.value()).get_track_ID();
+            auto timescale = MediaHeaderBoxView(mdhd.value()).get_timescale();
+            if (track_ID && timescale) {
+                output.push_back({track_ID.value(), timescale.value()});
+            }
+        }
+        return output;
+    }
+
+    /*
+     * Walks top level boxes from the moof at offset to the end of file,
+     * every box has to be complete. Only from the first moof of the file
+     * tracks without tfdt are allowed (they start at 0)
+     */
+    template <typename Fetch>
+    static std::optional<FragmentedDuration>
+        walk_fragments(Reader<Fetch> &reader, const Head &head, uint64_t offset)
+    {
+        bool from_start = offset == head.first_moof;
+
+        FragmentedDuration output;
+        output.fragment_count = 0;
+        uint32_t last_sequence_number = head.first_sequence_number;
+
+        while (offset < reader.file_size) {
+            auto header = reader.read_header(offset);
+            if (!header) {
+                return std::nullopt;
+            }
+            auto [type, box_size] = header.value();
+
+            if (type == moof_tag) {
+                auto moof = reader.read(offset, box_size);
+                if (!moof || !has_mfhd(BoxView(moof.value()))) {
+                    return std::nullopt;
+                }
+
+                auto fragment = MovieFragment::parse(
+                    BoxView(moof.value()), offset, head.track_extends);
+                if (!fragment ||
+                    !add_fragment(output, fragment.value(), from_start)) {
+                    return std::nullopt;
+                }
+                output.fragment_count++;
+                last_sequence_number = fragment->sequence_number;
+            }
+
+            offset += box_size;
+        }
+
+        if (output.fragment_count == 0) {
+            return std::nullopt;
+        }
+
+        if (!from_start && last_sequence_number >= head.first_sequence_number) {
+            output.fragment_count =
+                last_sequence_number - head.first_sequence_number + 1;
+        }
+        return output;
+    }
+
+    // Tells a moof from "moof" bytes found inside other data
+    static bool has_mfhd(BoxView moof)
+    {
+        auto content = moof.get_content_data();
+        return content && find_box(content.value(), mfhd_tag);
+    }
+
+    static bool add_fragment(
+        FragmentedDuration &output,
+        const MovieFragment &fragment,
+        bool from_start)
+    {
+        for (auto &traf : fragment.tracks) {
+            auto track = std::ranges::find(
+                output.tracks, traf.track_ID, &Track::track_ID);
+            bool is_new = track == std::end(output.tracks);
+
+            uint64_t start = 0;
+            if (traf.base_media_decode_time) {
+                start = traf.base_media_decode_time.value();
+            } else if (!is_new) {
+                start = track->end_time;
+            } else if (!from_start) {
+                return false;
+            }
+
+            if (is_new) {
+                output.tracks.push_back({traf.track_ID, 0, std::nullopt});
+                track = std::prev(std::end(output.tracks));
+            }
+            track->end_time = start + traf.duration;
+        }
+        return true;
+    }
+
+    // All tracks of moov have fragments after the walk start
+    static bool has_all_tracks(
+        const FragmentedDuration &output, const Head &head)
+    {
+        return std::ranges::all_of(head.timescales, [&](auto &timescale) {
+            return std::ranges::find(
+                       output.tracks,
+                       timescale.track_ID,
+                       &Track::track_ID) != std::end(output.tracks);
+        });
+    }
+
+    // Walks from the earliest moof that is the last random access point
+    template <typename Fetch>
+    static std::optional<FragmentedDuration>
+        probe_mfra(Reader<Fetch> &reader, const Head &head)
+    {
+        auto random_access = FragmentRandomAccess::open(
+            reader.file_size,
+            [&reader](uint64_t offset, uint64_t size) {
+                return reader.read(offset, size);
+            });
+        if (!random_access) {
+            return std::nullopt;
+        }
+
+        std::optional<uint64_t> start;
+        for (uint32_t track_ID : random_access->get_track_IDs()) {
+            auto entry = random_access->find_entry(track_ID, UINT64_MAX);
+            if (entry && entry->moof_offset >= head.first_moof) {
+                start = std::min(
+                    start.value_or(UINT64_MAX), entry->moof_offset);
+            }
+        }
+        if (!start) {
+            return std::nullopt;
+        }
+
+        auto output = walk_fragments(reader, head, start.value());
+        if (output) {
+            output->source = Source::MFRA;
+        }
+        return output;
+    }
+
+    /*
+     * moof candidates are found backwards by their type in the tail
+     * window and confirmed by walking complete boxes from them to the
+     * end of file
+     */
+    template <typename Fetch>
+    static std::optional<FragmentedDuration> probe_tail(
+        Reader<Fetch> &reader,
+        const Head &head,
+        uint64_t tail_size,
+        uint64_t max_tail_size)
+    {
+        uint64_t file_size = reader.file_size;
+        uint64_t data_start = head.first_moof;
+        uint64_t scanned_start = file_size;
+        constexpr uint64_t tag_size = 4;
+
+        std::vector<uint64_t> candidates;
+        while (scanned_start > data_start) {
+            uint64_t window_start =
+                file_size - std::min(file_size - data_start, tail_size);
+            /*
+             * Only bytes before the previous (smaller) window are read,
+             * plus the tags of boxes starting in its first 4 bytes, which
+             * it could not match
+             */
+            uint64_t scan_end = std::min(scanned_start + tag_size, file_size);
+            uint64_t read_end = std::min(scan_end + tag_size - 1, file_size);
+            auto window = reader.read(window_start, read_end - window_start);
+            if (!window) {
+                return std::nullopt;
+            }
+
+            // Boxes starting before the previous window, latest first
+            candidates.clear();
+            for (size_t tag_pos = scan_end - window_start;
+                 tag_pos-- > sizeof(uint32_t);) {
+                if (is_tag_at(window.value(), tag_pos, moof_tag)) {
+                    candidates.push_back(
+                        window_start + tag_pos - sizeof(uint32_t));
+                }
+            }
+
+            // window may be invalidated by the reads of the walk
+            for (uint64_t moof_offset : candidates) {
+                auto output = walk_fragments(reader, head, moof_offset);
+                if (output && has_all_tracks(output.value(), head)) {
+                    output->source = Source::TAIL_SCAN;
+                    return output;
+                }
+            }
+
+            scanned_start = window_start;
+            if (tail_size >= max_tail_size) {
+                break;
+            }
+            tail_size = std::min(tail_size * 2, max_tail_size);
+        }
+
+        return std::nullopt;
+    }
+
+    static bool
+        is_tag_at(std::span<const std::byte> data, size_t pos, TypeTag tag)
+    {
+        if (pos + 4 > data.size()) {
+            return false;
+        }
+        for (size_t idx = 0; idx < 4; idx++) {
+            if (std::to_integer<uint8_t>(data[pos + idx]) != tag.data[idx]) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+} // namespace Mpeg4
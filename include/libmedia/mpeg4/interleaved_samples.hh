@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <compare>
+#include <functional>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4/sample_index.hh"
+#include "libmedia/mpeg4/timescale.hh"
+
+namespace Mpeg4 {
+
+/*
+ * Walks samples of several tracks merged by decode time
+ *
+ * Track times are rescaled to one common timescale, samples with equal
+ * rescaled dts are reported in file offset order so reading them back
+ * stays as sequential as the file layout allows
+ *
+ * Merge uses a min-heap with one entry per track and one SampleCursor
+ * per track, allocated once on construction, next() does not allocate
+ */
+template <SampleIndex Table>
+struct InterleavedSamples
+{
+    struct Track
+    {
+        const Table *table;
+        uint32_t timescale;
+    };
+
+    struct Item
+    {
+        uint32_t track; // index in tracks passed to constructor
+        uint32_t sample_index;
+        uint64_t offset;
+        uint32_t size;
+        uint64_t dts; // in common timescale
+        bool is_sync;
+    };
+
+    InterleavedSamples(std::span<const Track> tracks, uint32_t timescale)
+        : m_tracks(std::begin(tracks), std::end(tracks)), m_timescale(timescale)
+    {
+        m_next_sample.resize(m_tracks.size(), 0);
+        m_heap.reserve(m_tracks.size());
+        m_cursors.reserve(m_tracks.size());
+        for (auto &track : m_tracks) {
+            m_cursors.emplace_back();
+            if (track.table) {
+                m_cursors.back().emplace(*track.table);
+            }
+        }
+
+        for (uint32_t track_idx = 0; track_idx < m_tracks.size(); track_idx++) {
+            push_track_head(track_idx);
+        }
+    }
+
+    uint32_t get_timescale() const
+    {
+        return m_timescale;
+    }
+
+    std::optional<Item> next()
+    {
+        if (m_heap.empty()) {
+            return std::nullopt;
+        }
+
+        std::ranges::pop_heap(m_heap, std::greater{}, &HeapEntry::key);
+        HeapEntry head = m_heap.back();
+        m_heap.pop_back();
+
+        m_next_sample[head.track]++;
+        push_track_head(head.track);
+
+        return Item{
+            head.track,
+            head.sample_index,
+            head.sample.offset,
+            static_cast<uint32_t>(head.sample.size),
+            head.key.dts,
+            head.sample.is_sync};
+    }
+
+  private:
+    struct HeapKey
+    {
+        uint64_t dts;
+        uint64_t offset;
+
+        auto operator<=>(const HeapKey &) const = default;
+    };
+
+    using Sample =
+        decltype(std::declval<const Table &>().get_sample_unsafe(0));
+
+    struct HeapEntry
+    {
+        HeapKey key;
+        uint32_t track;
+        uint32_t sample_index;
+        Sample sample;
+    };
+
+    std::vector<Track> m_tracks;
+    uint32_t m_timescale;
+    std::vector<uint32_t> m_next_sample;
+    std::vector<HeapEntry> m_heap;
+    // Empty for tracks without table
+    std::vector<std::optional<SampleCursor<Table>>> m_cursors;
+
+    void push_track_head(uint32_t track_idx)
+    {
+        auto &track = m_tracks[track_idx];
+        uint32_t sample_idx = m_next_sample[track_idx];
+        if (track.table == nullptr || track.timescale == 0 ||
+            sample_idx >= track.table->get_sample_count()) {
+            return;
+        }
+
+        auto sample = m_cursors[track_idx]->get_sample_unsafe(sample_idx);
+        HeapKey key{
+            rescale_time(sample.dts, track.timescale, m_timescale),
+            sample.offset};
+
+        m_heap.push_back({key, track_idx, sample_idx, sample});
+        std::ranges::push_heap(m_heap, std::greater{}, &HeapEntry::key);
+    }
+};
+
+} // namespace Mpeg4
@@ -0,0 +1,424 @@
+#pragma once
+
+#include <algorithm>
+#include <expected>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+#include "libmedia/mpeg4/sample_index.hh"
+#include "libmedia/mpeg4/sample_table.hh"
+
+namespace Mpeg4 {
+
+/*
+ * SampleTable decoded on demand in blocks of block_size samples
+ *
+ * Opening walks only stts and stsc runs to store one checkpoint per block
+ * (first sample dts and offset plus positions inside stts and stsc),
+ * blocks are decoded from the boxes on first access and memoized.
+ * Sync sample lookups are binary searches directly in stss, which is
+ * checked to be ordered and in range when opening
+ *
+ * Table keeps views into stbl, so the box data must outlive it.
+ * Lookups are safe to call from several threads
+ */
+struct LazySampleTable
+{
+    static constexpr uint32_t block_size = 4096;
+
+    using Sample = SampleTable::Sample;
+    using BuildError = SampleTableError;
+
+    static std::expected<LazySampleTable, BuildError> open(BoxView stbl)
+    {
+        auto boxes = SampleTableBoxes::find(stbl);
+        if (!boxes) {
+            return std::unexpected(boxes.error());
+        }
+        return open(boxes.value());
+    }
+
+    static std::expected<LazySampleTable, BuildError>
+        open(const SampleTableBoxes &boxes)
+    {
+        LazySampleTable output(boxes);
+
+        if (auto error = output.load_time_checkpoints()) {
+            return std::unexpected(error.value());
+        }
+        if (auto error = output.load_chunk_checkpoints()) {
+            return std::unexpected(error.value());
+        }
+        if (auto error = output.check_sync_samples()) {
+            return std::unexpected(error.value());
+        }
+
+        size_t block_count = output.m_checkpoints.size();
+        output.m_blocks.resize(block_count);
+        output.m_blocks_once = std::make_unique<std::once_flag[]>(block_count);
+
+        return output;
+    }
+
+    uint32_t get_sample_count() const
+    {
+        return m_sample_count;
+    }
+
+    uint64_t get_duration() const
+    {
+        return m_duration;
+    }
+
+    uint32_t get_block_count() const
+    {
+        return m_checkpoints.size();
+    }
+
+    std::optional<Sample> get_sample(uint32_t sample_index) const
+    {
+        if (sample_index >= m_sample_count) {
+            return std::nullopt;
+        }
+        return get_sample_unsafe(sample_index);
+    }
+
+    Sample get_sample_unsafe(uint32_t sample_index) const
+    {
+        auto &block = get_block(sample_index / block_size);
+        uint32_t local = sample_index % block_size;
+
+        Sample output;
+        output.offset = block.offsets[local];
+        output.size = block.sizes[local];
+        output.dts = block.dts[local];
+        output.duration = block.dts[local + 1] - block.dts[local];
+        output.is_sync = is_sync_sample_unsafe(sample_index);
+        return output;
+    }
+
+    bool is_sync_sample_unsafe(uint32_t sample_index) const
+    {
+        auto sync = find_sync_sample_before(sample_index);
+        return sync.has_value() && sync.value() == sample_index;
+    }
+
+    // Sample being decoded at dts, std::nullopt past the last sample
+    std::optional<uint32_t> find_sample_at_time(uint64_t dts) const
+    {
+        if (dts >= m_duration) {
+            return std::nullopt;
+        }
+
+        auto checkpoint_it = std::ranges::upper_bound(
+            m_checkpoints, dts, {}, &Checkpoint::dts);
+        checkpoint_it--;
+        uint32_t block_idx =
+            std::distance(std::begin(m_checkpoints), checkpoint_it);
+
+        auto &block = get_block(block_idx);
+        auto sample_ends = std::span(block.dts).subspan(1);
+        auto end_it = std::ranges::upper_bound(sample_ends, dts);
+        if (end_it == std::end(sample_ends)) {
+            return std::nullopt;
+        }
+        return block_idx * block_size +
+            std::distance(std::begin(sample_ends), end_it);
+    }
+
+    // Last sync sample at or before sample_index
+    std::optional<uint32_t> find_sync_sample_before(uint32_t sample_index) const
+    {
+        if (sample_index >= m_sample_count) {
+            return std::nullopt;
+        }
+        if (!m_boxes.stss) {
+            return sample_index;
+        }
+
+        // Binary search of the last sample_number <= sample_index + 1
+        auto &stss = m_boxes.stss.value();
+        uint32_t low = 0;
+        uint32_t high = m_sync_count;
+        while (low < high) {
+            uint32_t middle = low + (high - low) / 2;
+            if (stss.get_sample_number_unsafe(middle) <= sample_index + 1) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+
+        if (low == 0) {
+            return std::nullopt;
+        }
+        return stss.get_sample_number_unsafe(low - 1) - 1;
+    }
+
+  private:
+    struct Checkpoint
+    {
+        uint64_t dts;    // of the first block sample
+        uint64_t offset; // of the first block sample
+        uint32_t stts_entry;
+        uint32_t stts_consumed; // samples of stts_entry before the block
+        uint32_t stsc_entry;
+        uint32_t chunk;          // 1-based
+        uint32_t chunk_consumed; // samples of chunk before the block
+    };
+
+    struct Block
+    {
+        std::vector<uint64_t> offsets;
+        std::vector<uint32_t> sizes;
+        std::vector<uint64_t> dts; // sample count + 1 entries
+    };
+
+    SampleTableBoxes m_boxes;
+    uint32_t m_sample_count = 0;
+    uint32_t m_sync_count = 0;
+    uint64_t m_duration = 0;
+    std::optional<uint32_t> m_constant_size;
+
+    std::vector<Checkpoint> m_checkpoints;
+    mutable std::vector<Block> m_blocks;
+    mutable std::unique_ptr<std::once_flag[]> m_blocks_once;
+
+    LazySampleTable(const SampleTableBoxes &boxes) : m_boxes(boxes)
+    {
+        m_sample_count = m_boxes.stsz.get_samples_count().value();
+        m_constant_size = m_boxes.stsz.get_default_sample_size();
+        if (m_boxes.stss) {
+            m_sync_count = m_boxes.stss->get_entry_count().value();
+        }
+
+        uint32_t block_count = (m_sample_count + block_size - 1) / block_size;
+        m_checkpoints.resize(block_count);
+    }
+
+    uint32_t get_sample_size_unsafe(uint32_t sample_index) const
+    {
+        if (m_constant_size) {
+            return m_constant_size.value();
+        }
+        return m_boxes.stsz.get_sample_size_at_unsafe(sample_index);
+    }
+
+    // Next chunk after stsc run given by entry_idx, or chunk_count + 1
+    uint64_t get_run_end_chunk(uint32_t entry_idx, uint32_t entry_count) const
+    {
+        if (entry_idx + 1 < entry_count) {
+            return m_boxes.stsc.get_entry_unsafe(entry_idx + 1).first_chunk;
+        }
+        return uint64_t(m_boxes.get_chunk_count()) + 1;
+    }
+
+    std::optional<BuildError> load_time_checkpoints()
+    {
+        auto &stts = m_boxes.stts;
+        uint32_t entry_count = stts.get_entry_count().value();
+
+        uint64_t sample_idx = 0;
+        uint64_t dts = 0;
+        uint32_t block_idx = 0;
+
+        for (uint32_t entry_idx = 0;
+             entry_idx < entry_count && sample_idx < m_sample_count;
+             entry_idx++) {
+            auto entry = stts.get_entry_unsafe(entry_idx);
+            uint64_t run_end = std::min<uint64_t>(
+                m_sample_count, sample_idx + entry.sample_count);
+
+            while (block_idx < m_checkpoints.size() &&
+                   uint64_t(block_idx) * block_size < run_end) {
+                uint64_t consumed =
+                    uint64_t(block_idx) * block_size - sample_idx;
+                auto &checkpoint = m_checkpoints[block_idx];
+                checkpoint.dts = dts + consumed * entry.sample_delta;
+                checkpoint.stts_entry = entry_idx;
+                checkpoint.stts_consumed = consumed;
+                block_idx++;
+            }
+
+            dts += (run_end - sample_idx) * entry.sample_delta;
+            sample_idx = run_end;
+        }
+
+        if (sample_idx != m_sample_count) {
+            return BuildError::STTS_SAMPLE_COUNT_MISMATCH;
+        }
+        m_duration = dts;
+
+        return std::nullopt;
+    }
+
+    std::optional<BuildError> load_chunk_checkpoints()
+    {
+        auto &stsc = m_boxes.stsc;
+        uint32_t entry_count = stsc.get_entry_count().value();
+        uint32_t chunk_count = m_boxes.get_chunk_count();
+
+        uint64_t sample_idx = 0;
+        uint32_t block_idx = 0;
+
+        for (uint32_t entry_idx = 0;
+             entry_idx < entry_count && sample_idx < m_sample_count;
+             entry_idx++) {
+            auto entry = stsc.get_entry_unsafe(entry_idx);
+            uint64_t next_first_chunk =
+                get_run_end_chunk(entry_idx, entry_count);
+
+            if (entry.first_chunk == 0 ||
+                entry.first_chunk >= next_first_chunk ||
+                next_first_chunk > uint64_t(chunk_count) + 1) {
+                return BuildError::INVALID_STSC;
+            }
+
+            uint64_t run_samples = (next_first_chunk - entry.first_chunk) *
+                entry.samples_per_chunk;
+            uint64_t run_end =
+                std::min<uint64_t>(m_sample_count, sample_idx + run_samples);
+
+            while (block_idx < m_checkpoints.size() &&
+                   uint64_t(block_idx) * block_size < run_end) {
+                uint64_t in_run =
+                    uint64_t(block_idx) * block_size - sample_idx;
+                auto &checkpoint = m_checkpoints[block_idx];
+                checkpoint.stsc_entry = entry_idx;
+                checkpoint.chunk =
+                    entry.first_chunk + in_run / entry.samples_per_chunk;
+                checkpoint.chunk_consumed = in_run % entry.samples_per_chunk;
+
+                /*
+                 * Offset is carried from the previous checkpoint when it
+                 * is in the same chunk, so every sample size is summed
+                 * at most once over the whole table
+                 */
+                uint32_t first = block_idx * block_size;
+                uint32_t summed_from = first - checkpoint.chunk_consumed;
+                uint64_t offset =
+                    m_boxes.get_chunk_offset_unsafe(checkpoint.chunk - 1);
+                if (block_idx > 0 &&
+                    m_checkpoints[block_idx - 1].chunk == checkpoint.chunk) {
+                    summed_from = first - block_size;
+                    offset = m_checkpoints[block_idx - 1].offset;
+                }
+                for (uint32_t idx = summed_from; idx < first; idx++) {
+                    offset += get_sample_size_unsafe(idx);
+                }
+                checkpoint.offset = offset;
+
+                block_idx++;
+            }
+
+            sample_idx = run_end;
+        }
+
+        if (sample_idx != m_sample_count) {
+            return BuildError::CHUNK_SAMPLE_COUNT_MISMATCH;
+        }
+
+        return std::nullopt;
+    }
+
+    // Same rules as SampleTable, lookups binary search stss
+    std::optional<BuildError> check_sync_samples() const
+    {
+        if (!m_boxes.stss) {
+            return std::nullopt;
+        }
+
+        auto &stss = m_boxes.stss.value();
+        uint32_t previous_number = 0;
+        for (uint32_t entry_idx = 0; entry_idx < m_sync_count; entry_idx++) {
+            uint32_t sample_number = stss.get_sample_number_unsafe(entry_idx);
+            if (sample_number <= previous_number ||
+                sample_number > m_sample_count) {
+                return BuildError::INVALID_STSS;
+            }
+            previous_number = sample_number;
+        }
+
+        return std::nullopt;
+    }
+
+    const Block &get_block(uint32_t block_idx) const
+    {
+        std::call_once(m_blocks_once[block_idx], [this, block_idx]() {
+            materialize(block_idx);
+        });
+        return m_blocks[block_idx];
+    }
+
+    void materialize(uint32_t block_idx) const
+    {
+        auto checkpoint = m_checkpoints[block_idx];
+        uint32_t first = block_idx * block_size;
+        uint32_t count = std::min(block_size, m_sample_count - first);
+
+        Block &block = m_blocks[block_idx];
+        block.offsets.resize(count);
+        block.sizes.resize(count);
+        block.dts.resize(count + 1);
+
+        for (uint32_t idx = 0; idx < count; idx++) {
+            block.sizes[idx] = get_sample_size_unsafe(first + idx);
+        }
+
+        auto &stts = m_boxes.stts;
+        uint32_t stts_entry = checkpoint.stts_entry;
+        auto time_run = stts.get_entry_unsafe(stts_entry);
+        uint32_t time_run_left =
+            time_run.sample_count - checkpoint.stts_consumed;
+        uint64_t dts = checkpoint.dts;
+
+        for (uint32_t idx = 0; idx < count; idx++) {
+            while (time_run_left == 0) {
+                time_run = stts.get_entry_unsafe(++stts_entry);
+                time_run_left = time_run.sample_count;
+            }
+            block.dts[idx] = dts;
+            dts += time_run.sample_delta;
+            time_run_left--;
+        }
+        block.dts[count] = dts;
+
+        auto &stsc = m_boxes.stsc;
+        uint32_t stsc_count = stsc.get_entry_count().value();
+        uint32_t stsc_entry = checkpoint.stsc_entry;
+        uint32_t samples_per_chunk =
+            stsc.get_entry_unsafe(stsc_entry).samples_per_chunk;
+        uint64_t run_end_chunk = get_run_end_chunk(stsc_entry, stsc_count);
+        uint32_t chunk = checkpoint.chunk;
+        uint32_t chunk_left = samples_per_chunk - checkpoint.chunk_consumed;
+        uint64_t offset = checkpoint.offset;
+
+        for (uint32_t idx = 0; idx < count; idx++) {
+            while (chunk_left == 0) {
+                chunk++;
+                while (chunk >= run_end_chunk) {
+                    stsc_entry++;
+                    samples_per_chunk =
+                        stsc.get_entry_unsafe(stsc_entry).samples_per_chunk;
+                    run_end_chunk = get_run_end_chunk(stsc_entry, stsc_count);
+                }
+                chunk_left = samples_per_chunk;
+                offset = m_boxes.get_chunk_offset_unsafe(chunk - 1);
+            }
+            block.offsets[idx] = offset;
+            offset += block.sizes[idx];
+            chunk_left--;
+        }
+    }
+};
+
+static_assert(SampleIndex<LazySampleTable>);
+
+} // namespace Mpeg4
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <algorithm>
+#include <expected>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+#include "libmedia/mpeg4/fragment_index.hh"
+#include "libmedia/mpeg4/track_extends.hh"
+
+namespace Mpeg4 {
+
+/*
+ * Indexes fragments of a file that is still being written
+ *
+ * Bytes are fed in file order, either as data appended since the last
+ * call or as a new mapping of the whole file. Only moof and moov (for
+ * trex defaults) boxes are buffered, other boxes are skipped by size.
+ * A fragment is added to the index once the mdat following its moof is
+ * complete, so a partially written trailing fragment stays pending and
+ * every byte is read once
+ */
+struct LiveFragmentIndexer
+{
+    constexpr static TypeTag moof_tag = TypeTag::from_str("moof");
+    constexpr static TypeTag moov_tag = TypeTag::from_str("moov");
+
+    constexpr static uint64_t default_max_moof_size = 64 * 1024 * 1024;
+
+    LiveFragmentIndexer(uint64_t max_moof_size = default_max_moof_size)
+        : m_max_moof_size(max_moof_size)
+    {
+    }
+
+    // Bytes appended to the file since the previous call
+    void append(std::span<const std::byte> data)
+    {
+        m_fed_size += data.size();
+
+        while (!data.empty() && !m_failed && !m_open_ended) {
+            if (m_skip_remaining > 0) {
+                uint64_t count =
+                    std::min<uint64_t>(m_skip_remaining, data.size());
+                m_skip_remaining -= count;
+                data = data.subspan(count);
+                if (m_skip_remaining == 0) {
+                    finish_box();
+                }
+                continue;
+            }
+
+            if (!m_box_header) {
+                data = read_header(data);
+                continue;
+            }
+
+            // moof and moov content is buffered for parsing
+            uint64_t count = std::min<uint64_t>(
+                m_box_size - m_buffer.size(), data.size());
+            m_buffer.insert(
+                std::end(m_buffer), std::begin(data), std::begin(data) + count);
+            data = data.subspan(count);
+            if (m_buffer.size() == m_box_size) {
+                finish_box();
+            }
+        }
+    }
+
+    /*
+     * Whole file as mapped now, bytes before get_fed_size() must be
+     * unchanged and are not read again
+     */
+    void update(std::span<const std::byte> file)
+    {
+        if (file.size() > m_fed_size) {
+            append(file.subspan(m_fed_size));
+        }
+    }
+
+    const FragmentIndex &get_index() const
+    {
+        return m_index;
+    }
+
+    // Number of file bytes fed so far
+    uint64_t get_fed_size() const
+    {
+        return m_fed_size;
+    }
+
+    // File offset up to which every box is complete and indexed
+    uint64_t get_indexed_size() const
+    {
+        return m_indexed_size;
+    }
+
+    // A box of unknown size (to the end of file) was found
+    bool is_open_ended() const
+    {
+        return m_open_ended;
+    }
+
+    // Malformed box was found, further bytes are ignored
+    bool has_failed() const
+    {
+        return m_failed;
+    }
+
+  private:
+    FragmentIndex m_index;
+    TrackExtends m_track_extends;
+    uint64_t m_max_moof_size;
+
+    uint64_t m_fed_size = 0;
+    uint64_t m_indexed_size = 0;
+    bool m_open_ended = false;
+    bool m_failed = false;
+
+    // Box being read
+    uint64_t m_box_offset = 0;
+    uint64_t m_box_size = 0;
+    std::optional<BoxHeader> m_box_header;
+    uint64_t m_skip_remaining = 0;
+    std::vector<std::byte> m_buffer;
+
+    // Parsed moof waiting for its mdat
+    std::optional<MovieFragment> m_pending;
+
+    /*
+     * Collects header bytes, returns data left after them
+     *
+     * Header sizes are multiples of 8 (size, type, largesize, usertype),
+     * so it is read 8 bytes at a time until it parses
+     */
+    std::span<const std::byte> read_header(std::span<const std::byte> data)
+    {
+        constexpr size_t step = 8;
+
+        std::expected<BoxHeader, BoxView::GetHeaderError> header =
+            std::unexpected(BoxView::GetHeaderError::NO_SIZE_DATA);
+        while (!data.empty()) {
+            size_t count =
+                std::min(step - m_buffer.size() % step, data.size());
+            m_buffer.insert(
+                std::end(m_buffer), std::begin(data), std::begin(data) + count);
+            data = data.subspan(count);
+            if (m_buffer.size() % step != 0) {
+                return data;
+            }
+
+            header = BoxView(m_buffer).get_header();
+            if (header ||
+                header.error() == BoxView::GetHeaderError::INVALID_SIZE) {
+                break;
+            }
+        }
+
+        if (!header) {
+            if (header.error() == BoxView::GetHeaderError::INVALID_SIZE) {
+                m_failed = true;
+            }
+            return data;
+        }
+
+        if (!header->box_content_size) {
+            m_open_ended = true;
+            return data;
+        }
+
+        m_box_header = header.value();
+        m_box_size = header->header_size + header->box_content_size.value();
+        bool is_moof = header->type == moof_tag;
+        if (is_moof && m_box_size > m_max_moof_size) {
+            m_failed = true;
+            return data;
+        }
+
+        // moov too large to buffer is skipped, trex defaults are lost
+        bool is_small_moov =
+            header->type == moov_tag && m_box_size <= m_max_moof_size;
+        if (is_moof || is_small_moov) {
+            if (m_buffer.size() == m_box_size) {
+                finish_box();
+            }
+            return data;
+        }
+
+        m_skip_remaining = m_box_size - m_buffer.size();
+        m_buffer.clear();
+        if (m_skip_remaining == 0) {
+            finish_box();
+        }
+        return data;
+    }
+
+    void finish_box()
+    {
+        TypeTag type = m_box_header->type;
+
+        if (type == moof_tag) {
+            commit_pending();
+            m_pending = MovieFragment::parse(
+                BoxView(m_buffer), m_box_offset, m_track_extends);
+            if (!m_pending) {
+                m_failed = true;
+            }
+        } else {
+            // Box after moof (its mdat) is complete
+            commit_pending();
+        }
+
+        if (type == moov_tag && !m_buffer.empty()) {
+            m_track_extends = TrackExtends::from_moov(BoxView(m_buffer));
+        }
+
+        m_box_offset += m_box_size;
+        m_box_header.reset();
+        m_buffer.clear();
+
+        if (!m_pending) {
+            m_indexed_size = m_box_offset;
+        }
+    }
+
+    void commit_pending()
+    {
+        if (m_pending) {
+            m_index.append(m_pending.value());
+            m_pending.reset();
+        }
+    }
+};
+
+} // namespace Mpeg4
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <algorithm>
+#include <optional>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4/box/SampleToGroupBoxView.hh"
+
+namespace Mpeg4 {
+
+/*
+ * Sample to group description mapping of one sbgp kept as runs
+ *
+ * Adjacent runs with the same description are merged, lookup is
+ * a binary search over run ends: O(log runs) with 8 bytes per run
+ *
+ * Samples past the last run map to default_index: 0 (no group) or
+ * default_group_description_index of a version 2 sgpd
+ */
+struct SampleGroupMap
+{
+    static constexpr std::optional<SampleGroupMap>
+        build(const SampleToGroupBoxView &sbgp, uint32_t default_index = 0)
+    {
+        auto entry_count = sbgp.get_entry_count();
+        if (!entry_count) {
+            return std::nullopt;
+        }
+
+        SampleGroupMap output;
+        output.m_grouping_type = sbgp.get_grouping_type().value();
+        output.m_default_index = default_index;
+
+        uint64_t run_end = 0;
+        for (uint32_t entry_idx = 0; entry_idx < entry_count.value();
+             entry_idx++) {
+            auto entry = sbgp.get_entry_unsafe(entry_idx);
+            if (entry.sample_count == 0) {
+                continue;
+            }
+
+            run_end += entry.sample_count;
+            if (run_end > UINT32_MAX) {
+                return std::nullopt;
+            }
+
+            if (!output.m_run_ends.empty() &&
+                output.m_description_indices.back() ==
+                    entry.group_description_index) {
+                output.m_run_ends.back() = run_end;
+                continue;
+            }
+
+            output.m_run_ends.push_back(run_end);
+            output.m_description_indices.push_back(
+                entry.group_description_index);
+        }
+
+        output.m_run_ends.shrink_to_fit();
+        output.m_description_indices.shrink_to_fit();
+        return output;
+    }
+
+    constexpr uint32_t get_grouping_type() const
+    {
+        return m_grouping_type;
+    }
+
+    constexpr uint32_t get_run_count() const
+    {
+        return m_run_ends.size();
+    }
+
+    // Samples covered by sbgp runs
+    constexpr uint32_t get_mapped_sample_count() const
+    {
+        if (m_run_ends.empty()) {
+            return 0;
+        }
+        return m_run_ends.back();
+    }
+
+    /*
+     * 1-based index into sgpd entries (values above 0x10000 refer
+     * to sgpd of the same track fragment), 0 - sample is in no group
+     */
+    constexpr uint32_t get_group_description_index(uint32_t sample_index) const
+    {
+        auto run = std::ranges::upper_bound(m_run_ends, sample_index);
+        if (run == std::end(m_run_ends)) {
+            return m_default_index;
+        }
+        return m_description_indices[run - std::begin(m_run_ends)];
+    }
+
+  private:
+    uint32_t m_grouping_type = 0;
+    uint32_t m_default_index = 0;
+    std::vector<uint32_t> m_run_ends; // one past the last sample of a run
+    std::vector<uint32_t> m_description_indices;
+
+    constexpr SampleGroupMap() = default;
+};
+
+/*
+ * Sequential walk over sbgp runs in place, O(1) per sample
+ * without building a SampleGroupMap
+ */
+struct SampleGroupCursor
+{
+    constexpr SampleGroupCursor(
+        SampleToGroupBoxView sbgp,
+        uint32_t default_index = 0)
+        : m_sbgp(sbgp), m_default_index(default_index)
+    {
+        m_entry_count = m_sbgp.get_entry_count().value_or(0);
+        load_entry();
+    }
+
+    // Index of the sample next() reports
+    constexpr uint32_t get_sample_index() const
+    {
+        return m_sample_index;
+    }
+
+    // Group description index of the current sample, advances by one
+    constexpr uint32_t next()
+    {
+        m_sample_index++;
+
+        if (m_entry_index >= m_entry_count) {
+            return m_default_index;
+        }
+
+        uint32_t output = m_current.group_description_index;
+        m_consumed++;
+        if (m_consumed >= m_current.sample_count) {
+            m_entry_index++;
+            load_entry();
+        }
+        return output;
+    }
+
+  private:
+    SampleToGroupBoxView m_sbgp;
+    uint32_t m_default_index;
+    uint32_t m_entry_count = 0;
+    uint32_t m_entry_index = 0;
+    uint32_t m_consumed = 0;
+    uint32_t m_sample_index = 0;
+    SampleToGroupBoxView::Entry m_current{};
+
+    // Loads current entry skipping empty runs
+    constexpr void load_entry()
+    {
+        m_consumed = 0;
+        for (; m_entry_index < m_entry_count; m_entry_index++) {
+            m_current = m_sbgp.get_entry_unsafe(m_entry_index);
+            if (m_current.sample_count != 0) {
+                return;
+            }
+        }
+    }
+};
+
+} // namespace Mpeg4
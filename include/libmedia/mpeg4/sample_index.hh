@@ -0,0 +1,50 @@
+#pragma once
+
+#include <concepts>
+#include <optional>
+
+#include <cstdint>
+
+namespace Mpeg4 {
+
+/*
+ * Sample lookups shared by SampleTable, CompactSampleTable
+ * and LazySampleTable
+ */
+template <typename T>
+concept SampleIndex = requires(const T &table, uint32_t sample, uint64_t dts) {
+    { table.get_sample_count() } -> std::convertible_to<uint32_t>;
+    { table.get_duration() } -> std::convertible_to<uint64_t>;
+    { table.find_sample_at_time(dts) } -> std::same_as<std::optional<uint32_t>>;
+    {
+        table.find_sync_sample_before(sample)
+    } -> std::same_as<std::optional<uint32_t>>;
+    { table.get_sample_unsafe(sample).offset } -> std::convertible_to<uint64_t>;
+    { table.get_sample_unsafe(sample).size } -> std::convertible_to<uint64_t>;
+    { table.get_sample_unsafe(sample).dts } -> std::convertible_to<uint64_t>;
+    { table.get_sample_unsafe(sample).is_sync } -> std::convertible_to<bool>;
+};
+
+/*
+ * Reads samples of a table in (mostly) increasing order
+ *
+ * Tables whose random access decodes more than the one sample
+ * specialize it to keep the decoded state between calls
+ */
+template <SampleIndex Table>
+struct SampleCursor
+{
+    explicit SampleCursor(const Table &table) : m_table(&table)
+    {
+    }
+
+    auto get_sample_unsafe(uint32_t sample_index)
+    {
+        return m_table->get_sample_unsafe(sample_index);
+    }
+
+  private:
+    const Table *m_table;
+};
+
+} // namespace Mpeg4
@@ -0,0 +1,682 @@
+#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <expected>
+#include <latch>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/executor.hh"
+#include "libmedia/mpeg4.hh"
+#include "libmedia/mpeg4/box_sequence.hh"
+#include "libmedia/mpeg4/sample_index.hh"
+
+#include "libmedia/mpeg4/box/ChunkOffset64BoxView.hh"
+#include "libmedia/mpeg4/box/ChunkOffsetBoxView.hh"
+#include "libmedia/mpeg4/box/SampleSizeBoxView.hh"
+#include "libmedia/mpeg4/box/SampleToChunkBoxView.hh"
+#include "libmedia/mpeg4/box/SyncSampleBoxView.hh"
+#include "libmedia/mpeg4/box/TimeToSampleBoxView.hh"
+
+namespace Mpeg4 {
+
+enum class SampleTableError
+{
+    NO_STTS,
+    NO_STSC,
+    NO_STSZ,
+    NO_CHUNK_OFFSETS,
+    STTS_SAMPLE_COUNT_MISMATCH,
+    INVALID_STSC,
+    CHUNK_SAMPLE_COUNT_MISMATCH,
+    INVALID_STSS,
+};
+
+// Validated children of stbl needed to locate and time samples
+struct SampleTableBoxes
+{
+    TimeToSampleBoxView stts;
+    SampleToChunkBoxView stsc;
+    SampleSizeBoxView stsz;
+    std::optional<ChunkOffsetBoxView> stco;
+    std::optional<ChunkOffset64BoxView> co64;
+    std::optional<SyncSampleBoxView> stss;
+
+    static std::expected<SampleTableBoxes, SampleTableError> find(BoxView stbl)
+    {
+        auto stbl_data = stbl.get_content_data();
+        if (!stbl_data) {
+            return std::unexpected(SampleTableError::NO_STSZ);
+        }
+
+        auto find_child = [&stbl_data](TypeTag tag) {
+            return find_box(stbl_data.value(), tag);
+        };
+
+        auto stts_box = find_child(TimeToSampleBoxView::stts_tag);
+        auto stsc_box = find_child(SampleToChunkBoxView::stsc_tag);
+        auto stsz_box = find_child(SampleSizeBoxView::stsz_tag);
+        auto stco_box = find_child(ChunkOffsetBoxView::stco_tag);
+        auto co64_box = find_child(ChunkOffset64BoxView::co64_tag);
+        auto stss_box = find_child(SyncSampleBoxView::stss_tag);
+
+        if (!stts_box || TimeToSampleBoxView(*stts_box).is_not_valid()) {
+            return std::unexpected(SampleTableError::NO_STTS);
+        }
+        if (!stsc_box || SampleToChunkBoxView(*stsc_box).is_not_valid()) {
+            return std::unexpected(SampleTableError::NO_STSC);
+        }
+        if (!stsz_box || SampleSizeBoxView(*stsz_box).is_not_valid()) {
+            return std::unexpected(SampleTableError::NO_STSZ);
+        }
+
+        SampleTableBoxes output{
+            TimeToSampleBoxView(*stts_box),
+            SampleToChunkBoxView(*stsc_box),
+            SampleSizeBoxView(*stsz_box),
+            std::nullopt,
+            std::nullopt,
+            std::nullopt};
+
+        if (stco_box && ChunkOffsetBoxView(*stco_box).is_valid()) {
+            output.stco = ChunkOffsetBoxView(*stco_box);
+        } else if (co64_box && ChunkOffset64BoxView(*co64_box).is_valid()) {
+            output.co64 = ChunkOffset64BoxView(*co64_box);
+        } else {
+            return std::unexpected(SampleTableError::NO_CHUNK_OFFSETS);
+        }
+
+        /*
+         * ISO/IEC 14496-12 8.6.2.1
+         * If the sync sample box is not present, every sample is a sync
+         * sample
+         */
+        if (stss_box) {
+            output.stss = SyncSampleBoxView(*stss_box);
+            if (output.stss->is_not_valid()) {
+                return std::unexpected(SampleTableError::INVALID_STSS);
+            }
+        }
+
+        return output;
+    }
+
+    uint32_t get_chunk_count() const
+    {
+        if (stco) {
+            return stco->get_entry_count().value();
+        }
+        return co64->get_entry_count().value();
+    }
+
+    // chunk_index is 0-based
+    uint64_t get_chunk_offset_unsafe(uint32_t chunk_index) const
+    {
+        if (stco) {
+            return stco->get_chunk_offset_unsafe(chunk_index);
+        }
+        return co64->get_chunk_offset_unsafe(chunk_index);
+    }
+};
+
+/*
+ * Per sample file offset, size, decode time and sync flag of one track,
+ * flattened from stbl boxes (stts, stsc, stsz, stco/co64, stss)
+ *
+ * Sample indices are 0-based, times are in media timescale
+ */
+struct SampleTable
+{
+    struct Sample
+    {
+        uint64_t offset;
+        uint32_t size;
+        uint64_t dts;
+        uint32_t duration;
+        bool is_sync;
+    };
+
+    using BuildError = SampleTableError;
+
+    static std::expected<SampleTable, BuildError> build(BoxView stbl)
+    {
+        auto boxes = SampleTableBoxes::find(stbl);
+        if (!boxes) {
+            return std::unexpected(boxes.error());
+        }
+        return build(boxes.value());
+    }
+
+    static std::expected<SampleTable, BuildError>
+        build(const SampleTableBoxes &boxes)
+    {
+        SampleTable output;
+
+        if (auto error = output.load_sizes(boxes.stsz)) {
+            return std::unexpected(error.value());
+        }
+
+        if (auto error = output.load_times(boxes.stts)) {
+            return std::unexpected(error.value());
+        }
+
+        if (auto error = output.load_offsets(boxes)) {
+            return std::unexpected(error.value());
+        }
+
+        output.m_all_sync = !boxes.stss.has_value();
+        if (boxes.stss) {
+            if (auto error = output.load_sync_samples(boxes.stss.value())) {
+                return std::unexpected(error.value());
+            }
+        }
+
+        return output;
+    }
+
+    static constexpr uint32_t default_segment_samples = 1 << 16;
+
+    /*
+     * Same table as build(boxes), built by tasks on executor
+     *
+     * Work is split into segments of about segment_samples samples:
+     * sample sizes by sample ranges, decode times by stts entry ranges
+     * and offsets by whole chunks of stsc runs. Decode time segments are
+     * summed first and fixed up with a prefix sum of the preceding ones,
+     * offset segments start at chunk boundaries and need no fix-up
+     */
+    template <Executor E>
+    static std::expected<SampleTable, BuildError> build(
+        const SampleTableBoxes &boxes,
+        E &executor,
+        uint32_t segment_samples = default_segment_samples)
+    {
+        SampleTable output;
+        segment_samples = std::max<uint32_t>(1, segment_samples);
+
+        auto &stsz = boxes.stsz;
+        auto &stts = boxes.stts;
+
+        output.m_sample_count = stsz.get_samples_count().value();
+        auto default_size = stsz.get_default_sample_size();
+        if (default_size) {
+            output.m_constant_size = default_size.value();
+        } else {
+            output.m_sizes.resize(output.m_sample_count);
+        }
+        output.m_dts.resize(output.m_sample_count + 1);
+
+        auto segment_count = [segment_samples](uint32_t count) {
+            return (uint64_t(count) + segment_samples - 1) / segment_samples;
+        };
+
+        size_t size_segments = 0;
+        if (!default_size) {
+            size_segments = segment_count(output.m_sample_count);
+        }
+
+        struct TimeSegment
+        {
+            uint64_t sample_count = 0;
+            uint64_t duration = 0;
+        };
+
+        uint32_t stts_entry_count = stts.get_entry_count().value();
+        std::vector<TimeSegment> time_segments(segment_count(stts_entry_count));
+
+        auto time_segment_entries = [&](size_t segment_idx) {
+            uint64_t begin = uint64_t(segment_idx) * segment_samples;
+            uint64_t end =
+                std::min<uint64_t>(stts_entry_count, begin + segment_samples);
+            return std::pair<uint32_t, uint32_t>(begin, end);
+        };
+
+        parallel_for(
+            executor,
+            size_segments + time_segments.size(),
+            [&](size_t task_idx) {
+                if (task_idx < size_segments) {
+                    uint64_t begin = uint64_t(task_idx) * segment_samples;
+                    uint64_t end = std::min<uint64_t>(
+                        output.m_sample_count, begin + segment_samples);
+                    output.fill_sizes(stsz, begin, end);
+                    return;
+                }
+
+                size_t segment_idx = task_idx - size_segments;
+                auto [begin, end] = time_segment_entries(segment_idx);
+                auto &segment = time_segments[segment_idx];
+                for (uint32_t entry_idx = begin; entry_idx < end;
+                     entry_idx++) {
+                    auto entry = stts.get_entry_unsafe(entry_idx);
+                    segment.sample_count += entry.sample_count;
+                    segment.duration +=
+                        uint64_t(entry.sample_count) * entry.sample_delta;
+                }
+            });
+
+        // Prefix fix-up: each segment starts where the preceding ones end
+        uint64_t sample_base = 0;
+        uint64_t dts_base = 0;
+        for (auto &segment : time_segments) {
+            uint64_t sample_count = segment.sample_count;
+            uint64_t duration = segment.duration;
+            segment.sample_count = sample_base;
+            segment.duration = dts_base;
+            sample_base += sample_count;
+            dts_base += duration;
+        }
+        if (sample_base < output.m_sample_count) {
+            return std::unexpected(BuildError::STTS_SAMPLE_COUNT_MISMATCH);
+        }
+
+        output.m_offsets.resize(output.m_sample_count);
+        auto chunk_runs = output.plan_chunk_runs(boxes, segment_samples);
+        if (!chunk_runs) {
+            return std::unexpected(chunk_runs.error());
+        }
+
+        parallel_for(
+            executor,
+            time_segments.size() + chunk_runs->size(),
+            [&](size_t task_idx) {
+                if (task_idx < time_segments.size()) {
+                    auto &segment = time_segments[task_idx];
+                    if (segment.sample_count >= output.m_sample_count) {
+                        return;
+                    }
+                    auto [begin, end] = time_segment_entries(task_idx);
+                    output.fill_times(
+                        stts,
+                        begin,
+                        end,
+                        segment.sample_count,
+                        segment.duration);
+                    return;
+                }
+
+                auto &run = chunk_runs.value()[task_idx - time_segments.size()];
+                output.fill_offsets(boxes, run);
+            });
+
+        output.m_all_sync = !boxes.stss.has_value();
+        if (boxes.stss) {
+            if (auto error = output.load_sync_samples(boxes.stss.value())) {
+                return std::unexpected(error.value());
+            }
+        }
+
+        return output;
+    }
+
+    uint32_t get_sample_count() const
+    {
+        return m_sample_count;
+    }
+
+    // Sum of all sample durations
+    uint64_t get_duration() const
+    {
+        return m_dts.back();
+    }
+
+    std::optional<Sample> get_sample(uint32_t sample_index) const
+    {
+        if (sample_index >= m_sample_count) {
+            return std::nullopt;
+        }
+        return get_sample_unsafe(sample_index);
+    }
+
+    Sample get_sample_unsafe(uint32_t sample_index) const
+    {
+        Sample output;
+        output.offset = m_offsets[sample_index];
+        output.size = get_sample_size_unsafe(sample_index);
+        output.dts = m_dts[sample_index];
+        output.duration = m_dts[sample_index + 1] - m_dts[sample_index];
+        output.is_sync = is_sync_sample_unsafe(sample_index);
+        return output;
+    }
+
+    uint32_t get_sample_size_unsafe(uint32_t sample_index) const
+    {
+        if (m_sizes.empty()) {
+            return m_constant_size;
+        }
+        return m_sizes[sample_index];
+    }
+
+    bool is_sync_sample_unsafe(uint32_t sample_index) const
+    {
+        if (m_all_sync) {
+            return true;
+        }
+        return std::ranges::binary_search(m_sync_samples, sample_index);
+    }
+
+    // Sample being decoded at dts, std::nullopt past the last sample
+    std::optional<uint32_t> find_sample_at_time(uint64_t dts) const
+    {
+        auto sample_ends = std::span(m_dts).subspan(1);
+        auto end_it = std::ranges::upper_bound(sample_ends, dts);
+        if (end_it == std::end(sample_ends)) {
+            return std::nullopt;
+        }
+        return std::distance(std::begin(sample_ends), end_it);
+    }
+
+    // Last sync sample at or before sample_index
+    std::optional<uint32_t> find_sync_sample_before(uint32_t sample_index) const
+    {
+        if (sample_index >= m_sample_count) {
+            return std::nullopt;
+        }
+        if (m_all_sync) {
+            return sample_index;
+        }
+
+        auto sync_it = std::ranges::upper_bound(m_sync_samples, sample_index);
+        if (sync_it == std::begin(m_sync_samples)) {
+            return std::nullopt;
+        }
+        sync_it--;
+        return *sync_it;
+    }
+
+  private:
+    SampleTable() = default;
+
+    uint32_t m_sample_count = 0;
+    uint32_t m_constant_size = 0;
+    bool m_all_sync = true;
+
+    std::vector<uint64_t> m_offsets;
+    std::vector<uint32_t> m_sizes; // empty if all samples have same size
+    std::vector<uint64_t> m_dts;   // sample_count + 1 entries
+    std::vector<uint32_t> m_sync_samples;
+
+    // Chunks [first_chunk, first_chunk + chunk_count) of one stsc entry
+    struct ChunkRun
+    {
+        uint32_t first_chunk; // 1-based
+        uint32_t chunk_count;
+        uint32_t samples_per_chunk;
+        uint32_t first_sample;
+    };
+
+    std::optional<BuildError> load_sizes(SampleSizeBoxView stsz)
+    {
+        m_sample_count = stsz.get_samples_count().value();
+
+        auto default_size = stsz.get_default_sample_size();
+        if (default_size) {
+            m_constant_size = default_size.value();
+            return std::nullopt;
+        }
+
+        m_sizes.resize(m_sample_count);
+        fill_sizes(stsz, 0, m_sample_count);
+        return std::nullopt;
+    }
+
+    void fill_sizes(SampleSizeBoxView stsz, uint32_t begin, uint32_t end)
+    {
+        for (uint32_t sample_idx = begin; sample_idx < end; sample_idx++) {
+            m_sizes[sample_idx] = stsz.get_sample_size_at_unsafe(sample_idx);
+        }
+    }
+
+    std::optional<BuildError> load_times(TimeToSampleBoxView stts)
+    {
+        m_dts.resize(m_sample_count + 1);
+
+        uint32_t entry_count = stts.get_entry_count().value();
+        if (fill_times(stts, 0, entry_count, 0, 0) != m_sample_count) {
+            return BuildError::STTS_SAMPLE_COUNT_MISMATCH;
+        }
+
+        return std::nullopt;
+    }
+
+    /*
+     * Decode times of samples described by stts entries
+     * [entry_begin, entry_end) starting from sample_idx at dts,
+     * returns index of the sample following the last one filled
+     */
+    uint32_t fill_times(
+        TimeToSampleBoxView stts,
+        uint32_t entry_begin,
+        uint32_t entry_end,
+        uint32_t sample_idx,
+        uint64_t dts)
+    {
+        for (uint32_t entry_idx = entry_begin;
+             entry_idx < entry_end && sample_idx < m_sample_count;
+             entry_idx++) {
+            auto entry = stts.get_entry_unsafe(entry_idx);
+            uint32_t run_end = std::min<uint64_t>(
+                m_sample_count, uint64_t(sample_idx) + entry.sample_count);
+            for (; sample_idx < run_end; sample_idx++) {
+                m_dts[sample_idx] = dts;
+                dts += entry.sample_delta;
+            }
+
+            if (sample_idx == m_sample_count) {
+                m_dts[m_sample_count] = dts;
+            }
+        }
+
+        return sample_idx;
+    }
+
+    std::optional<BuildError> load_offsets(const SampleTableBoxes &boxes)
+    {
+        m_offsets.resize(m_sample_count);
+
+        auto chunk_runs = plan_chunk_runs(boxes, UINT32_MAX);
+        if (!chunk_runs) {
+            return chunk_runs.error();
+        }
+
+        for (auto &run : chunk_runs.value()) {
+            fill_offsets(boxes, run);
+        }
+
+        return std::nullopt;
+    }
+
+    /*
+     * Splits stsc entries into runs of whole chunks holding about
+     * segment_samples samples, validating stsc on the way
+     */
+    std::expected<std::vector<ChunkRun>, BuildError>
+        plan_chunk_runs(
+            const SampleTableBoxes &boxes, uint32_t segment_samples) const
+    {
+        std::vector<ChunkRun> output;
+
+        auto &stsc = boxes.stsc;
+        uint32_t chunk_count = boxes.get_chunk_count();
+
+        uint32_t entry_count = stsc.get_entry_count().value();
+        uint32_t sample_idx = 0;
+
+        for (uint32_t entry_idx = 0;
+             entry_idx < entry_count && sample_idx < m_sample_count;
+             entry_idx++) {
+            auto entry = stsc.get_entry_unsafe(entry_idx);
+
+            uint64_t next_first_chunk = uint64_t(chunk_count) + 1;
+            if (entry_idx + 1 < entry_count) {
+                next_first_chunk =
+                    stsc.get_entry_unsafe(entry_idx + 1).first_chunk;
+            }
+
+            if (entry.first_chunk == 0 ||
+                entry.first_chunk >= next_first_chunk ||
+                next_first_chunk > uint64_t(chunk_count) + 1) {
+                return std::unexpected(BuildError::INVALID_STSC);
+            }
+
+            uint32_t chunks_per_run = std::max<uint32_t>(
+                1,
+                segment_samples /
+                    std::max<uint32_t>(1, entry.samples_per_chunk));
+
+            for (uint64_t chunk = entry.first_chunk;
+                 chunk < next_first_chunk && sample_idx < m_sample_count;
+                 chunk += chunks_per_run) {
+                uint32_t run_chunks = std::min<uint64_t>(
+                    chunks_per_run, next_first_chunk - chunk);
+                output.emplace_back(
+                    chunk, run_chunks, entry.samples_per_chunk, sample_idx);
+
+                sample_idx = std::min<uint64_t>(
+                    m_sample_count,
+                    sample_idx +
+                        uint64_t(run_chunks) * entry.samples_per_chunk);
+            }
+        }
+
+        if (sample_idx != m_sample_count) {
+            return std::unexpected(BuildError::CHUNK_SAMPLE_COUNT_MISMATCH);
+        }
+
+        return output;
+    }
+
+    void fill_offsets(const SampleTableBoxes &boxes, const ChunkRun &run)
+    {
+        uint32_t sample_idx = run.first_sample;
+        uint64_t chunk_end = uint64_t(run.first_chunk) + run.chunk_count;
+
+        for (uint64_t chunk = run.first_chunk;
+             chunk < chunk_end && sample_idx < m_sample_count;
+             chunk++) {
+            uint64_t offset = boxes.get_chunk_offset_unsafe(chunk - 1);
+            uint32_t sample_end = std::min<uint64_t>(
+                m_sample_count, uint64_t(sample_idx) + run.samples_per_chunk);
+            for (; sample_idx < sample_end; sample_idx++) {
+                m_offsets[sample_idx] = offset;
+                offset += get_sample_size_unsafe(sample_idx);
+            }
+        }
+    }
+
+    std::optional<BuildError> load_sync_samples(SyncSampleBoxView stss)
+    {
+        uint32_t entry_count = stss.get_entry_count().value();
+        m_sync_samples.resize(entry_count);
+
+        uint32_t previous_number = 0;
+        for (uint32_t entry_idx = 0; entry_idx < entry_count; entry_idx++) {
+            uint32_t sample_number = stss.get_sample_number_unsafe(entry_idx);
+            if (sample_number <= previous_number ||
+                sample_number > m_sample_count) {
+                return BuildError::INVALID_STSS;
+            }
+            m_sync_samples[entry_idx] = sample_number - 1;
+            previous_number = sample_number;
+        }
+
+        return std::nullopt;
+    }
+};
+
+static_assert(SampleIndex<SampleTable>);
+
+/*
+ * Sample tables of several tracks (stbl boxes) built on executor
+ *
+ * Each track is built independently by one task, tracks longer than
+ * segment_samples are split into segments by SampleTable::build instead
+ * so one long track does not serialize the whole probe
+ */
+template <Executor E>
+std::vector<std::expected<SampleTable, SampleTableError>> build_sample_tables(
+    std::span<const BoxView> stbls,
+    E &executor,
+    uint32_t segment_samples = SampleTable::default_segment_samples)
+{
+    std::vector<std::expected<SampleTable, SampleTableError>> output(
+        stbls.size(), std::unexpected(SampleTableError::NO_STSZ));
+
+    std::vector<std::optional<SampleTableBoxes>> boxes(stbls.size());
+    std::vector<size_t> short_tracks;
+    std::vector<size_t> long_tracks;
+
+    for (size_t track_idx = 0; track_idx < stbls.size(); track_idx++) {
+        auto track_boxes = SampleTableBoxes::find(stbls[track_idx]);
+        if (!track_boxes) {
+            output[track_idx] = std::unexpected(track_boxes.error());
+            continue;
+        }
+
+        uint32_t sample_count = track_boxes->stsz.get_samples_count().value();
+        if (sample_count > segment_samples) {
+            long_tracks.push_back(track_idx);
+        } else {
+            short_tracks.push_back(track_idx);
+        }
+        boxes[track_idx] = track_boxes.value();
+    }
+
+    /*
+     * Short track tasks reference locals of this function, so they are
+     * all waited for before any exception leaves it
+     */
+    std::latch short_done(short_tracks.size());
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto set_error = [&](std::exception_ptr current) {
+        std::lock_guard lock(error_mutex);
+        if (!error) {
+            error = std::move(current);
+        }
+    };
+
+    for (size_t submit_idx = 0; submit_idx < short_tracks.size();
+         submit_idx++) {
+        size_t track_idx = short_tracks[submit_idx];
+        try {
+            executor.submit([&, track_idx]() {
+                try {
+                    output[track_idx] =
+                        SampleTable::build(boxes[track_idx].value());
+                } catch (...) {
+                    set_error(std::current_exception());
+                }
+                short_done.count_down();
+            });
+        } catch (...) {
+            set_error(std::current_exception());
+            short_done.count_down(short_tracks.size() - submit_idx);
+            break;
+        }
+    }
+
+    try {
+        for (size_t track_idx : long_tracks) {
+            output[track_idx] = SampleTable::build(
+                boxes[track_idx].value(), executor, segment_samples);
+        }
+    } catch (...) {
+        set_error(std::current_exception());
+    }
+
+    short_done.wait();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return output;
+}
+
+} // namespace Mpeg4
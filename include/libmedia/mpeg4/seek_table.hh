@@ -0,0 +1,231 @@
+#pragma once
+
+#include <algorithm>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4/sample_index.hh"
+#include "libmedia/varint.hh"
+
+namespace Mpeg4 {
+
+/*
+ * Seek points of one track precomputed every interval of media time
+ *
+ * Entry k describes time k * interval: sample decoded at that time,
+ * preceding sync sample and its file offset. A seek is one entry lookup
+ * plus a forward scan over samples of less than one interval
+ *
+ * Table can be stored with serialize() and loaded with deserialize()
+ */
+struct SeekTable
+{
+    struct Entry
+    {
+        uint32_t first_sample; // sample decoded at k * interval
+        uint32_t sync_sample;  // last sync sample at or before first_sample
+        uint64_t sync_offset;  // file offset of sync_sample
+    };
+
+    struct SeekPoint
+    {
+        uint32_t sample;      // sample decoded at requested time
+        uint32_t sync_sample; // decoding starts here
+        uint64_t sync_offset;
+    };
+
+    // interval is in media timescale, e.g. timescale / 2 for 500 ms
+    template <SampleIndex Table>
+    static std::optional<SeekTable> build(const Table &table, uint64_t interval)
+    {
+        if (interval == 0) {
+            return std::nullopt;
+        }
+
+        SeekTable output;
+        output.m_interval = interval;
+
+        uint64_t duration = table.get_duration();
+        uint64_t entry_count =
+            duration / interval + (duration % interval != 0 ? 1 : 0);
+        output.m_entries.reserve(entry_count);
+
+        for (uint64_t entry_idx = 0; entry_idx < entry_count; entry_idx++) {
+            auto sample = table.find_sample_at_time(entry_idx * interval);
+            if (!sample) {
+                break;
+            }
+
+            uint32_t sync_sample =
+                table.find_sync_sample_before(sample.value()).value_or(0);
+            output.m_entries.emplace_back(
+                sample.value(),
+                sync_sample,
+                table.get_sample_unsafe(sync_sample).offset);
+        }
+
+        return output;
+    }
+
+    uint64_t get_interval() const
+    {
+        return m_interval;
+    }
+
+    uint32_t get_entry_count() const
+    {
+        return m_entries.size();
+    }
+
+    std::optional<Entry> get_entry(uint32_t entry_index) const
+    {
+        if (entry_index >= m_entries.size()) {
+            return std::nullopt;
+        }
+        return m_entries[entry_index];
+    }
+
+    /*
+     * Seek point of dts in table the seek table was built from,
+     * std::nullopt past the last sample or when the entry does not
+     * fit table (table loaded for another track or file)
+     */
+    template <SampleIndex Table>
+    std::optional<SeekPoint> seek(const Table &table, uint64_t dts) const
+    {
+        uint64_t entry_idx = dts / m_interval;
+        if (entry_idx >= m_entries.size() || dts >= table.get_duration()) {
+            return std::nullopt;
+        }
+
+        auto &entry = m_entries[entry_idx];
+        uint32_t sample_count = table.get_sample_count();
+        if (entry.first_sample >= sample_count) {
+            return std::nullopt;
+        }
+
+        SeekPoint output{
+            entry.first_sample, entry.sync_sample, entry.sync_offset};
+
+        SampleCursor cursor(table);
+        for (uint32_t sample_idx = entry.first_sample + 1;
+             sample_idx < sample_count;
+             sample_idx++) {
+            auto sample = cursor.get_sample_unsafe(sample_idx);
+            if (sample.dts > dts) {
+                break;
+            }
+
+            output.sample = sample_idx;
+            if (sample.is_sync) {
+                output.sync_sample = sample_idx;
+                output.sync_offset = sample.offset;
+            }
+        }
+
+        return output;
+    }
+
+    /*
+     * Appends varint encoded table to output (container of uint8_t):
+     * version, interval, entry count, then per entry deltas
+     * from the previous one
+     */
+    template <typename Container>
+    void serialize(Container &output) const
+    {
+        write_varint(output, format_version);
+        write_varint(output, m_interval);
+        write_varint(output, m_entries.size());
+
+        Entry previous{0, 0, 0};
+        for (auto &entry : m_entries) {
+            write_varint(output, entry.first_sample - previous.first_sample);
+            write_varint(output, entry.first_sample - entry.sync_sample);
+            write_varint(
+                output,
+                zigzag_encode(
+                    static_cast<int64_t>(
+                        entry.sync_offset - previous.sync_offset)));
+            previous = entry;
+        }
+    }
+
+    /*
+     * Reads table written by serialize() starting at position
+     *
+     * Entries must move forward in samples, sync samples included,
+     * sample indices are checked against the table in seek()
+     */
+    static std::optional<SeekTable>
+        deserialize(std::span<const uint8_t> data, size_t &position)
+    {
+        auto version = try_read_varint(data, position);
+        auto interval = try_read_varint(data, position);
+        auto entry_count = try_read_varint(data, position);
+        if (!version || !interval || !entry_count) {
+            return std::nullopt;
+        }
+        if (version.value() != format_version || interval.value() == 0) {
+            return std::nullopt;
+        }
+
+        // Every entry takes at least 3 bytes
+        if (entry_count.value() > (data.size() - position) / 3) {
+            return std::nullopt;
+        }
+
+        SeekTable output;
+        output.m_interval = interval.value();
+        output.m_entries.reserve(entry_count.value());
+
+        Entry previous{0, 0, 0};
+        for (uint64_t entry_idx = 0; entry_idx < entry_count.value();
+             entry_idx++) {
+            auto sample_delta = try_read_varint(data, position);
+            auto sync_distance = try_read_varint(data, position);
+            auto offset_delta = try_read_varint(data, position);
+            if (!sample_delta || !sync_distance || !offset_delta) {
+                return std::nullopt;
+            }
+
+            if (sample_delta.value() > UINT32_MAX) {
+                return std::nullopt;
+            }
+            uint64_t first_sample =
+                uint64_t(previous.first_sample) + sample_delta.value();
+            if (first_sample > UINT32_MAX ||
+                sync_distance.value() > first_sample) {
+                return std::nullopt;
+            }
+
+            Entry entry;
+            entry.first_sample = first_sample;
+            entry.sync_sample = first_sample - sync_distance.value();
+            if (entry_idx != 0 && entry.sync_sample < previous.sync_sample) {
+                return std::nullopt;
+            }
+            entry.sync_offset = previous.sync_offset +
+                static_cast<uint64_t>(zigzag_decode(offset_delta.value()));
+
+            output.m_entries.push_back(entry);
+            previous = entry;
+        }
+
+        return output;
+    }
+
+  private:
+    static constexpr uint64_t format_version = 1;
+
+    uint64_t m_interval = 0;
+    std::vector<Entry> m_entries;
+
+    SeekTable() = default;
+};
+
+} // namespace Mpeg4
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+#include "libmedia/mpeg4/timescale.hh"
+
+#include "libmedia/mpeg4/box/SegmentIndexBoxView.hh"
+
+namespace Mpeg4 {
+
+/*
+ * References of one sidx flattened into cumulative presentation times
+ * and absolute file offsets, time to segment lookup is a binary search
+ */
+struct SegmentIndex
+{
+    struct Segment
+    {
+        uint64_t time;     // earliest presentation time, in timescale
+        uint64_t duration; // in timescale
+        uint32_t timescale;
+        uint64_t offset; // absolute file offset of referenced bytes
+        uint64_t size;
+        bool is_index; // references another sidx
+        bool starts_with_SAP;
+    };
+
+    // sidx_offset is the absolute file offset of the sidx box
+    static std::optional<SegmentIndex>
+        build(BoxView sidx, uint64_t sidx_offset)
+    {
+        SegmentIndexBoxView view(sidx);
+        auto reference_count = view.get_reference_count();
+        if (!reference_count || view.get_timescale().value() == 0) {
+            return std::nullopt;
+        }
+
+        auto header = sidx.get_header();
+        auto content = sidx.get_content_data();
+        if (!header || !content) {
+            return std::nullopt;
+        }
+        uint64_t sidx_end =
+            sidx_offset + header->header_size + content->size();
+
+        SegmentIndex output;
+        output.m_timescale = view.get_timescale().value();
+        output.m_times.resize(reference_count.value() + 1);
+        output.m_offsets.resize(reference_count.value() + 1);
+        output.m_flags.resize(reference_count.value());
+
+        uint64_t time = view.get_earliest_presentation_time().value();
+        uint64_t offset = sidx_end + view.get_first_offset().value();
+        for (uint16_t ref_idx = 0; ref_idx < reference_count.value();
+             ref_idx++) {
+            auto reference = view.get_reference_unsafe(ref_idx);
+            output.m_times[ref_idx] = time;
+            output.m_offsets[ref_idx] = offset;
+            uint8_t flags = 0;
+            flags |= reference.reference_type ? index_flag : 0;
+            flags |= reference.starts_with_SAP ? sap_flag : 0;
+            output.m_flags[ref_idx] = flags;
+
+            time += reference.subsegment_duration;
+            offset += reference.referenced_size;
+        }
+        output.m_times.back() = time;
+        output.m_offsets.back() = offset;
+
+        return output;
+    }
+
+    uint32_t get_timescale() const
+    {
+        return m_timescale;
+    }
+
+    uint32_t get_segment_count() const
+    {
+        return m_flags.size();
+    }
+
+    std::optional<Segment> get_segment(uint32_t segment_index) const
+    {
+        if (segment_index >= m_flags.size()) {
+            return std::nullopt;
+        }
+        return get_segment_unsafe(segment_index);
+    }
+
+    Segment get_segment_unsafe(uint32_t segment_index) const
+    {
+        Segment output;
+        output.time = m_times[segment_index];
+        output.duration = m_times[segment_index + 1] - output.time;
+        output.timescale = m_timescale;
+        output.offset = m_offsets[segment_index];
+        output.size = m_offsets[segment_index + 1] - output.offset;
+        output.is_index = (m_flags[segment_index] & index_flag) != 0;
+        output.starts_with_SAP =
+            (m_flags[segment_index] & sap_flag) != 0;
+        return output;
+    }
+
+    // Segment presented at time (in timescale of this index)
+    std::optional<uint32_t> find_segment_at_time(uint64_t time) const
+    {
+        auto segment_ends = std::span(m_times).subspan(1);
+        auto end_it = std::ranges::upper_bound(segment_ends, time);
+        if (time < m_times.front() || end_it == std::end(segment_ends)) {
+            return std::nullopt;
+        }
+        return std::distance(std::begin(segment_ends), end_it);
+    }
+
+  private:
+    constexpr static uint8_t index_flag = 0x1;
+    constexpr static uint8_t sap_flag = 0x2;
+
+    uint32_t m_timescale = 0;
+    std::vector<uint64_t> m_times;   // segment_count + 1 entries
+    std::vector<uint64_t> m_offsets; // segment_count + 1 entries
+    std::vector<uint8_t> m_flags;
+
+    SegmentIndex() = default;
+};
+
+/*
+ * Size of the sidx box at offset read from its header alone, at most
+ * max_size (the size of the reference to it)
+ */
+template <typename Fetch>
+    requires std::invocable<Fetch &, uint64_t, uint64_t>
+std::optional<uint64_t>
+fetch_box_size(uint64_t offset, uint64_t max_size, Fetch &fetch)
+{
+    constexpr uint64_t compact_header_size = 8;
+    constexpr uint64_t large_header_size = 16;
+
+    std::optional<std::span<const std::byte>> data =
+        fetch(offset, std::min(compact_header_size, max_size));
+    if (!data) {
+        return std::nullopt;
+    }
+    auto header = BoxView(data.value()).get_header();
+
+    if (!header &&
+        header.error() == BoxView::GetHeaderError::NO_BIG_SIZE_DATA &&
+        max_size >= large_header_size) {
+        data = fetch(offset, large_header_size);
+        if (!data) {
+            return std::nullopt;
+        }
+        header = BoxView(data.value()).get_header();
+    }
+
+    if (!header || header->type != SegmentIndexBoxView::sidx_tag) {
+        return std::nullopt;
+    }
+    // Size 0 box extends to the end of file, as does the reference
+    if (!header->box_content_size) {
+        return max_size;
+    }
+
+    uint64_t box_size = header->header_size + header->box_content_size.value();
+    if (box_size > max_size) {
+        return std::nullopt;
+    }
+    return box_size;
+}
+
+/*
+ * Media segment presented at time (in timescale of root), following
+ * references to other sidx boxes (hierarchical and daisy chained indexes)
+ *
+ * fetch(offset, size) returns exactly size bytes of the file. Only sidx
+ * bytes are read on the way down: the box header first (8 bytes, 16 with
+ * a 64 bit size), then the rest of the box, never the media it indexes
+ */
+template <typename Fetch>
+    requires std::invocable<Fetch &, uint64_t, uint64_t>
+std::optional<SegmentIndex::Segment> resolve_segment(
+    const SegmentIndex &root,
+    uint64_t time,
+    Fetch &&fetch,
+    size_t max_depth = 16)
+{
+    auto segment_idx = root.find_segment_at_time(time);
+    if (!segment_idx) {
+        return std::nullopt;
+    }
+    auto segment = root.get_segment_unsafe(segment_idx.value());
+
+    for (size_t depth = 0; segment.is_index; depth++) {
+        if (depth == max_depth) {
+            return std::nullopt;
+        }
+
+        /*
+         * referenced_size of an index reference spans the child sidx and
+         * all media it indexes, so the box size is taken from its header
+         */
+        auto sidx_size = fetch_box_size(segment.offset, segment.size, fetch);
+        if (!sidx_size) {
+            return std::nullopt;
+        }
+
+        std::optional<std::span<const std::byte>> data =
+            fetch(segment.offset, sidx_size.value());
+        if (!data) {
+            return std::nullopt;
+        }
+
+        BoxView sidx(data.value());
+        auto header = sidx.get_header();
+        if (!header || header->type != SegmentIndexBoxView::sidx_tag) {
+            return std::nullopt;
+        }
+
+        auto index = SegmentIndex::build(sidx, segment.offset);
+        if (!index) {
+            return std::nullopt;
+        }
+
+        uint64_t index_time =
+            rescale_time(time, root.get_timescale(), index->get_timescale());
+        auto child_idx = index->find_segment_at_time(index_time);
+        if (!child_idx) {
+            return std::nullopt;
+        }
+        segment = index->get_segment_unsafe(child_idx.value());
+    }
+
+    return segment;
+}
+
+} // namespace Mpeg4
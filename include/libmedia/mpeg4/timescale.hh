@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+
+namespace Mpeg4 {
+
+/*
+ * Converts time value from one timescale to another (rounding down)
+ * without overflowing on intermediate multiplication
+ */
+constexpr uint64_t rescale_time(uint64_t value, uint32_t from, uint32_t to)
+{
+    assert(from != 0);
+    if (from == to) {
+        return value;
+    }
+
+    uint64_t whole = value / from;
+    uint64_t rest = value % from;
+
+    if (whole > std::numeric_limits<uint64_t>::max() / to) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+
+    return whole * to + rest * to / from;
+}
+
+} // namespace Mpeg4
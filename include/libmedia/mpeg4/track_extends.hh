@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <optional>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+#include "libmedia/mpeg4/box_sequence.hh"
+
+#include "libmedia/mpeg4/box/MovieExtendsHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/TrackExtendsBoxView.hh"
+#include "libmedia/mpeg4/box/TrackFragmentHeaderBoxView.hh"
+
+namespace Mpeg4 {
+
+// Per sample values used when trun does not store them
+struct SampleDefaults
+{
+    uint32_t sample_description_index;
+    uint32_t sample_duration;
+    uint32_t sample_size;
+    uint32_t sample_flags;
+};
+
+/*
+ * trex defaults of all tracks of moov/mvex, sorted by track_ID
+ *
+ * Fragment decoding resolves tfhd over these once per traf with
+ * resolve(), so per sample decoding only copies the result
+ */
+struct TrackExtends
+{
+    static TrackExtends from_moov(BoxView moov)
+    {
+        constexpr TypeTag mvex_tag = TypeTag::from_str("mvex");
+
+        TrackExtends output;
+
+        auto moov_data = moov.get_content_data();
+        if (!moov_data) {
+            return output;
+        }
+        auto mvex = find_box(moov_data.value(), mvex_tag);
+        if (!mvex) {
+            return output;
+        }
+
+        BoxSequence children(mvex->get_content_data().value());
+        while (auto child = children.next()) {
+            TrackExtendsBoxView trex(child.value());
+            if (trex.is_valid()) {
+                output.m_tracks.push_back(
+                    {trex.get_track_ID().value(),
+                     {trex.get_default_sample_description_index().value(),
+                      trex.get_default_sample_duration().value(),
+                      trex.get_default_sample_size().value(),
+                      trex.get_default_sample_flags().value()}});
+                continue;
+            }
+
+            MovieExtendsHeaderBoxView mehd(child.value());
+            if (mehd.is_valid()) {
+                output.m_fragment_duration = mehd.get_fragment_duration();
+            }
+        }
+
+        std::ranges::sort(output.m_tracks, {}, &Track::track_ID);
+        return output;
+    }
+
+    std::optional<SampleDefaults> find(uint32_t track_ID) const
+    {
+        auto track =
+            std::ranges::lower_bound(m_tracks, track_ID, {}, &Track::track_ID);
+        if (track == std::end(m_tracks) || track->track_ID != track_ID) {
+            return std::nullopt;
+        }
+        return track->defaults;
+    }
+
+    // Duration of the whole fragmented movie from mehd, in movie timescale
+    std::optional<uint64_t> get_fragment_duration() const
+    {
+        return m_fragment_duration;
+    }
+
+    // tfhd defaults where present, trex defaults of the track otherwise
+    SampleDefaults resolve(const TrackFragmentHeaderBoxView &tfhd) const
+    {
+        SampleDefaults output = find(tfhd.get_track_ID().value_or(0))
+                                    .value_or(SampleDefaults{1, 0, 0, 0});
+
+        output.sample_description_index =
+            tfhd.get_sample_description_index().value_or(
+                output.sample_description_index);
+        output.sample_duration = tfhd.get_default_sample_duration().value_or(
+            output.sample_duration);
+        output.sample_size =
+            tfhd.get_default_sample_size().value_or(output.sample_size);
+        output.sample_flags =
+            tfhd.get_default_sample_flags().value_or(output.sample_flags);
+        return output;
+    }
+
+  private:
+    struct Track
+    {
+        uint32_t track_ID;
+        SampleDefaults defaults;
+    };
+
+    std::vector<Track> m_tracks;
+    std::optional<uint64_t> m_fragment_duration;
+};
+
+} // namespace Mpeg4
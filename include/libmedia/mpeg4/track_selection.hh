@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <ranges>
+#include <string_view>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4.hh"
+#include "libmedia/mpeg4/box_sequence.hh"
+
+#include "libmedia/mpeg4/box/HandlerBoxView.hh"
+#include "libmedia/mpeg4/box/MediaHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/TrackHeaderBoxView.hh"
+
+namespace Mpeg4 {
+
+struct TrackInfo
+{
+    BoxView trak;
+    uint32_t track_ID;
+    std::optional<uint32_t> handler_type;         // e.g. 'soun', 'vide'
+    std::optional<std::array<char, 3>> language; // ISO 639-2/T, e.g. "eng"
+};
+
+/*
+ * Track filter: values of one criterion are alternatives, criteria
+ * combine, an empty criterion accepts any track
+ */
+struct TrackSelection
+{
+    std::vector<uint32_t> track_IDs;
+    std::vector<uint32_t> handler_types;
+    std::vector<std::array<char, 3>> languages;
+
+    bool selects_all() const
+    {
+        return track_IDs.empty() && handler_types.empty() &&
+            languages.empty();
+    }
+
+    bool accepts_track_ID(uint32_t track_ID) const
+    {
+        return track_IDs.empty() ||
+            std::ranges::find(track_IDs, track_ID) != std::end(track_IDs);
+    }
+
+    bool accepts_media(
+        std::optional<uint32_t> handler_type,
+        std::optional<std::array<char, 3>> language) const
+    {
+        if (!handler_types.empty()) {
+            if (!handler_type ||
+                std::ranges::find(handler_types, handler_type.value()) ==
+                    std::end(handler_types)) {
+                return false;
+            }
+        }
+
+        if (!languages.empty()) {
+            if (!language ||
+                std::ranges::find(languages, language.value()) ==
+                    std::end(languages)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // "soun" -> 'soun'
+    static constexpr uint32_t handler_type_from_str(std::string_view str)
+    {
+        uint32_t output = 0;
+        for (size_t idx = 0; idx < 4; idx++) {
+            output <<= 8;
+            output |= idx < str.size() ? uint8_t(str[idx]) : uint8_t(' ');
+        }
+        return output;
+    }
+};
+
+inline std::array<char, 3> decode_language(std::array<std::byte, 3> packed)
+{
+    std::array<char, 3> output;
+    std::ranges::copy(
+        packed | std::views::transform(std::to_integer<char>),
+        std::begin(output));
+    std::ranges::for_each(output, [](char &c) { c += 0x60; });
+    return output;
+}
+
+/*
+ * Tracks of moov accepted by selection
+ *
+ * Only tkhd, mdhd and hdlr of every trak are read: a trak rejected
+ * by track_ID is left right after its tkhd, mdia children are walked
+ * until mdhd and hdlr are found, so sample tables in minf are skipped
+ * by box size without being read or validated
+ */
+inline std::vector<TrackInfo>
+    select_tracks(BoxView moov, const TrackSelection &selection)
+{
+    constexpr TypeTag trak_tag = TypeTag::from_str("trak");
+    constexpr TypeTag tkhd_tag = TypeTag::from_str("tkhd");
+    constexpr TypeTag mdia_tag = TypeTag::from_str("mdia");
+    constexpr TypeTag mdhd_tag = TypeTag::from_str("mdhd");
+    constexpr TypeTag hdlr_tag = TypeTag::from_str("hdlr");
+
+    std::vector<TrackInfo> output;
+
+    auto moov_data = moov.get_content_data();
+    if (!moov_data) {
+        return output;
+    }
+
+    BoxSequence moov_children(moov_data.value());
+    while (auto trak = moov_children.next()) {
+        if (trak->get_header()->type != trak_tag) {
+            continue;
+        }
+        auto trak_data = trak->get_content_data().value();
+
+        auto tkhd_box = find_box(trak_data, tkhd_tag);
+        if (!tkhd_box) {
+            continue;
+        }
+        auto track_ID = TrackHeaderBoxView(tkhd_box.value()).get_track_ID();
+        if (!track_ID || !selection.accepts_track_ID(track_ID.value())) {
+            continue;
+        }
+
+        TrackInfo info{trak.value(), track_ID.value(), {}, {}};
+
+        auto mdia_box = find_box(trak_data, mdia_tag);
+        if (mdia_box) {
+            BoxSequence mdia_children(mdia_box->get_content_data().value());
+            while (auto child = mdia_children.next()) {
+                auto type = child->get_header()->type;
+                if (type == mdhd_tag) {
+                    auto language =
+                        MediaHeaderBoxView(child.value()).get_language();
+                    if (language) {
+                        info.language = decode_language(language.value());
+                    }
+                }
+                if (type == hdlr_tag) {
+                    info.handler_type =
+                        HandlerBoxView(child.value()).get_handler_type();
+                }
+                if (info.language && info.handler_type) {
+                    break;
+                }
+            }
+        }
+
+        if (!selection.accepts_media(info.handler_type, info.language)) {
+            continue;
+        }
+        output.push_back(info);
+    }
+
+    return output;
+}
+
+} // namespace Mpeg4
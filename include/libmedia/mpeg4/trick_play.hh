@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4/box/SampleDependencyTypeBoxView.hh"
+#include "libmedia/mpeg4/sample_index.hh"
+#include "libmedia/raw_data.hh"
+
+namespace Mpeg4 {
+
+/*
+ * Per sample flags decoded from sdtp, one bit per sample and flag
+ *
+ * Decoding handles 8 samples per step with 64-bit SWAR arithmetic:
+ * 2-bit fields of 8 bytes are compared at once and the per-byte results
+ * are gathered into 8 bitmap bits with a single multiply
+ */
+struct SampleDependencies
+{
+    static constexpr std::optional<SampleDependencies>
+        decode(const SampleDependencyTypeBoxView &sdtp)
+    {
+        auto entries = sdtp.get_entries_data();
+        if (!entries) {
+            return std::nullopt;
+        }
+        auto data = entries.value();
+
+        SampleDependencies output;
+        output.m_sample_count = data.size();
+        size_t word_count = (data.size() + 63) / 64;
+        output.m_independent.resize(word_count, 0);
+        output.m_disposable.resize(word_count, 0);
+
+        size_t group_count = (data.size() + 7) / 8;
+        for (size_t group = 0; group < group_count; group++) {
+            auto group_data = data.subspan(group * 8);
+
+            std::array<std::byte, 8> bytes{};
+            std::copy_n(
+                std::begin(group_data),
+                std::min<size_t>(8, group_data.size()),
+                std::begin(bytes));
+            uint64_t packed = from_array_as_le<uint64_t>(bytes);
+
+            uint64_t depends_on = (packed >> 4) & lanes_low_2bit;
+            uint64_t is_depended_on = (packed >> 2) & lanes_low_2bit;
+
+            uint64_t independent_bits = gather(lanes_equal_2(depends_on));
+            uint64_t disposable_bits = gather(lanes_equal_2(is_depended_on));
+
+            size_t word = group / 8;
+            size_t shift = (group % 8) * 8;
+            output.m_independent[word] |= independent_bits << shift;
+            output.m_disposable[word] |= disposable_bits << shift;
+        }
+
+        // Padding bytes of the last group decode as "unknown" (0)
+        return output;
+    }
+
+    constexpr uint32_t get_sample_count() const
+    {
+        return m_sample_count;
+    }
+
+    // sample_depends_on == 2: does not depend on others (I picture)
+    constexpr bool is_independent(uint32_t sample_index) const
+    {
+        return test_bit(m_independent, sample_index);
+    }
+
+    // sample_is_depended_on == 2: no other sample references it
+    constexpr bool is_disposable(uint32_t sample_index) const
+    {
+        return test_bit(m_disposable, sample_index);
+    }
+
+  private:
+    static constexpr uint64_t lanes_low_2bit = 0x0303030303030303;
+    static constexpr uint64_t lanes_low_bit = 0x0101010101010101;
+
+    uint32_t m_sample_count = 0;
+    std::vector<uint64_t> m_independent;
+    std::vector<uint64_t> m_disposable;
+
+    constexpr SampleDependencies() = default;
+
+    // 0x01 in every byte lane holding value 2 (lanes hold 0..3)
+    static constexpr uint64_t lanes_equal_2(uint64_t lanes)
+    {
+        uint64_t high = (lanes >> 1) & lanes_low_bit;
+        uint64_t low = lanes & lanes_low_bit;
+        return high & ~low;
+    }
+
+    // Byte lane k with 0x01 becomes bit k
+    static constexpr uint64_t gather(uint64_t lanes)
+    {
+        return (lanes * 0x0102040810204080) >> 56;
+    }
+
+    constexpr bool
+        test_bit(const std::vector<uint64_t> &bitmap, uint32_t idx) const
+    {
+        if (idx >= m_sample_count) {
+            return false;
+        }
+        return (bitmap[idx / 64] >> (idx % 64)) & 1;
+    }
+};
+
+enum class TrickPlayMode
+{
+    SYNC_ONLY,      // I pictures only
+    REFERENCE_ONLY, // drop disposable samples (I + P)
+};
+
+/*
+ * Samples decodable without the dropped ones, decoded in
+ * [begin_dts, end_dts) starting from the preceding sync sample
+ *
+ * Without sample dependencies REFERENCE_ONLY can not drop anything
+ * and returns every sample of the range
+ */
+template <SampleIndex Table>
+std::vector<uint32_t> select_trick_play_samples(
+    const Table &table,
+    const SampleDependencies *dependencies,
+    uint64_t begin_dts,
+    uint64_t end_dts,
+    TrickPlayMode mode)
+{
+    std::vector<uint32_t> output;
+    if (begin_dts >= end_dts) {
+        return output;
+    }
+
+    auto first_sample = table.find_sample_at_time(begin_dts);
+    if (!first_sample) {
+        return output;
+    }
+
+    uint32_t begin_sample =
+        table.find_sync_sample_before(first_sample.value()).value_or(0);
+
+    uint32_t end_sample = table.get_sample_count();
+    auto last_sample = table.find_sample_at_time(end_dts - 1);
+    if (last_sample) {
+        end_sample = last_sample.value() + 1;
+    }
+
+    for (uint32_t sample_idx = begin_sample; sample_idx < end_sample;
+         sample_idx++) {
+        bool is_sync = table.find_sync_sample_before(sample_idx) == sample_idx;
+
+        switch (mode) {
+        case TrickPlayMode::SYNC_ONLY:
+            if (is_sync) {
+                output.push_back(sample_idx);
+            }
+            break;
+        case TrickPlayMode::REFERENCE_ONLY:
+            if (is_sync || dependencies == nullptr ||
+                !dependencies->is_disposable(sample_idx)) {
+                output.push_back(sample_idx);
+            }
+            break;
+        }
+    }
+
+    return output;
+}
+
+} // namespace Mpeg4
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <optional>
+#include <span>
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * LEB128 style variable length integers: 7 bits per byte,
+ * high bit set on every byte except the last one
+ */
+
+constexpr uint64_t zigzag_encode(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^
+        static_cast<uint64_t>(value >> 63);
+}
+
+constexpr int64_t zigzag_decode(uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+template <typename Container>
+constexpr void write_varint(Container &output, uint64_t value)
+{
+    while (value >= 0x80) {
+        output.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    output.push_back(static_cast<uint8_t>(value));
+}
+
+// Data is expected to be produced by write_varint
+constexpr uint64_t read_varint(std::span<const uint8_t> data, size_t &position)
+{
+    uint64_t output = 0;
+    for (size_t shift = 0; shift < 64; shift += 7) {
+        uint8_t part = data[position++];
+        output |= static_cast<uint64_t>(part & 0x7f) << shift;
+        if ((part & 0x80) == 0) {
+            break;
+        }
+    }
+    return output;
+}
+
+// Bounds checked read_varint, std::nullopt on truncated data
+constexpr std::optional<uint64_t>
+    try_read_varint(std::span<const uint8_t> data, size_t &position)
+{
+    uint64_t output = 0;
+    for (size_t shift = 0; shift < 64; shift += 7) {
+        if (position >= data.size()) {
+            return std::nullopt;
+        }
+        uint8_t part = data[position++];
+        output |= static_cast<uint64_t>(part & 0x7f) << shift;
+        if ((part & 0x80) == 0) {
+            return output;
+        }
+    }
+    return std::nullopt;
+}
@@ -12,14 +12,31 @@
 #include "libmedia/mpeg4.hh"
 #include "libmedia/mpeg4/dump.hh"
 
+#include "libmedia/mpeg4/box/EditListBoxView.hh"
 #include "libmedia/mpeg4/box/FileTypeBoxView.hh"
 #include "libmedia/mpeg4/box/HandlerBoxView.hh"
 #include "libmedia/mpeg4/box/MediaHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/MovieExtendsHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/MovieFragmentHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/MovieFragmentRandomAccessBoxView.hh"
+#include "libmedia/mpeg4/box/MovieFragmentRandomAccessOffsetBoxView.hh"
 #include "libmedia/mpeg4/box/MovieHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/SampleDependencyTypeBoxView.hh"
 #include "libmedia/mpeg4/box/SampleDescriptionBoxView.hh"
 #include "libmedia/mpeg4/box/SampleEntryBoxView.hh"
+#include "libmedia/mpeg4/box/SampleGroupDescriptionBoxView.hh"
 #include "libmedia/mpeg4/box/SampleSizeBoxView.hh"
+#include "libmedia/mpeg4/box/SampleToChunkBoxView.hh"
+#include "libmedia/mpeg4/box/SampleToGroupBoxView.hh"
+#include "libmedia/mpeg4/box/SegmentIndexBoxView.hh"
+#include "libmedia/mpeg4/box/SyncSampleBoxView.hh"
+#include "libmedia/mpeg4/box/TimeToSampleBoxView.hh"
+#include "libmedia/mpeg4/box/TrackExtendsBoxView.hh"
+#include "libmedia/mpeg4/box/TrackFragmentBaseMediaDecodeTimeBoxView.hh"
+#include "libmedia/mpeg4/box/TrackFragmentHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/TrackFragmentRandomAccessBoxView.hh"
 #include "libmedia/mpeg4/box/TrackHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/TrackRunBoxView.hh"
 
 static bool check(Mpeg4::FileTypeBoxView box)
 {
@@ -155,6 +172,12 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size)
             std::back_inserter(output), ",{}", Mpeg4::dump(co64_box));
     }
 
+    auto elst_box = Mpeg4::EditListBoxView(box);
+    if (elst_box.is_valid()) {
+        std::format_to(
+            std::back_inserter(output), ",{}", Mpeg4::dump(elst_box));
+    }
+
     auto stsz_box = Mpeg4::SampleSizeBoxView(box);
     if (stsz_box.is_valid()) {
         std::format_to(
@@ -171,5 +194,101 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size)
         return 0;
     }
 
+    auto stts_box = Mpeg4::TimeToSampleBoxView(box);
+    if (stts_box.is_valid()) {
+        std::format_to(
+            std::back_inserter(output), ",{}", Mpeg4::dump(stts_box));
+    }
+
+    auto stsc_box = Mpeg4::SampleToChunkBoxView(box);
+    if (stsc_box.is_valid()) {
+        std::format_to(
+            std::back_inserter(output), ",{}", Mpeg4::dump(stsc_box));
+    }
+
+    auto stss_box = Mpeg4::SyncSampleBoxView(box);
+    if (stss_box.is_valid()) {
+        std::format_to(
+            std::back_inserter(output), ",{}", Mpeg4::dump(stss_box));
+    }
+
+    auto sdtp_box = Mpeg4::SampleDependencyTypeBoxView(box);
+    if (sdtp_box.is_valid()) {
+        std::format_to(
+            std::back_inserter(output), ",{}", Mpeg4::dump(sdtp_box));
+    }
+
+    auto sbgp_box = Mpeg4::SampleToGroupBoxView(box);
+    if (sbgp_box.is_valid()) {
+        std::format_to(
+            std::back_inserter(output), ",{}", Mpeg4::dump(sbgp_box));
+    }
+
+    auto sgpd_box = Mpeg4::SampleGroupDescriptionBoxView(box);
+    if (sgpd_box.is_valid()) {
+        std::format_to(
+            std::back_inserter(output), ",{}", Mpeg4::dump(sgpd_box));
+    }
+
+    auto mfhd_box = Mpeg4::MovieFragmentHeaderBoxView(box);
+    if (mfhd_box.is_valid()) {
+        std::format_to(
+            std::back_inserter(output), ",{}", Mpeg4::dump(mfhd_box));
+    }
+
+    auto tfhd_box = Mpeg4::TrackFragmentHeaderBoxView(box);
+    if (tfhd_box.is_valid()) {
+        std::format_to(
+            std::back_inserter(output), ",{}", Mpeg4::dump(tfhd_box));
+    }
+
+    auto tfdt_box = Mpeg4::TrackFragmentBaseMediaDecodeTimeBoxView(box);
+    if (tfdt_box.is_valid()) {
+        std::format_to(
+            std::back_inserter(output), ",{}", Mpeg4::dump(tfdt_box));
+    }
+
+    auto trun_box = Mpeg4::TrackRunBoxView(box);
+    if (trun_box.is_valid()) {
+        std::format_to(
+            std::back_inserter(output), ",{}", Mpeg4::dump(trun_box));
+    }
+
+    auto sidx_box = Mpeg4::SegmentIndexBoxView(box);
+    if (sidx_box.is_valid()) {
+        std::format_to(
+            std::back_inserter(output), ",{}", Mpeg4::dump(sidx_box));
+    }
+
+    auto mfra_box = Mpeg4::MovieFragmentRandomAccessBoxView(box);
+    if (mfra_box.is_valid()) {
+        std::format_to(
+            std::back_inserter(output), ",{}", Mpeg4::dump(mfra_box));
+    }
+
+    auto mfro_box = Mpeg4::MovieFragmentRandomAccessOffsetBoxView(box);
+    if (mfro_box.is_valid()) {
+        std::format_to(
+            std::back_inserter(output), ",{}", Mpeg4::dump(mfro_box));
+    }
+
+    auto tfra_box = Mpeg4::TrackFragmentRandomAccessBoxView(box);
+    if (tfra_box.is_valid()) {
+        std::format_to(
+            std::back_inserter(output), ",{}", Mpeg4::dump(tfra_box));
+    }
+
+    auto mehd_box = Mpeg4::MovieExtendsHeaderBoxView(box);
+    if (mehd_box.is_valid()) {
+        std::format_to(
+            std::back_inserter(output), ",{}", Mpeg4::dump(mehd_box));
+    }
+
+    auto trex_box = Mpeg4::TrackExtendsBoxView(box);
+    if (trex_box.is_valid()) {
+        std::format_to(
+            std::back_inserter(output), ",{}", Mpeg4::dump(trex_box));
+    }
+
     return 0;
 }
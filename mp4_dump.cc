@@ -22,17 +22,38 @@
 #include <cstring>
 
 #include "libmedia/mpeg4.hh"
+#include "libmedia/mpeg4/box_sequence.hh"
 #include "libmedia/mpeg4/dump.hh"
+#include "libmedia/mpeg4/fragment_stream.hh"
+#include "libmedia/mpeg4/fragmented_duration.hh"
+#include "libmedia/mpeg4/track_selection.hh"
 
 #include "libmedia/mpeg4/box/ChunkOffset64BoxView.hh"
 #include "libmedia/mpeg4/box/ChunkOffsetBoxView.hh"
+#include "libmedia/mpeg4/box/EditListBoxView.hh"
 #include "libmedia/mpeg4/box/FileTypeBoxView.hh"
 #include "libmedia/mpeg4/box/HandlerBoxView.hh"
 #include "libmedia/mpeg4/box/MediaHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/MovieExtendsHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/MovieFragmentHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/MovieFragmentRandomAccessBoxView.hh"
+#include "libmedia/mpeg4/box/MovieFragmentRandomAccessOffsetBoxView.hh"
 #include "libmedia/mpeg4/box/MovieHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/SampleDependencyTypeBoxView.hh"
 #include "libmedia/mpeg4/box/SampleDescriptionBoxView.hh"
+#include "libmedia/mpeg4/box/SampleGroupDescriptionBoxView.hh"
 #include "libmedia/mpeg4/box/SampleSizeBoxView.hh"
+#include "libmedia/mpeg4/box/SampleToChunkBoxView.hh"
+#include "libmedia/mpeg4/box/SampleToGroupBoxView.hh"
+#include "libmedia/mpeg4/box/SegmentIndexBoxView.hh"
+#include "libmedia/mpeg4/box/SyncSampleBoxView.hh"
+#include "libmedia/mpeg4/box/TimeToSampleBoxView.hh"
+#include "libmedia/mpeg4/box/TrackExtendsBoxView.hh"
+#include "libmedia/mpeg4/box/TrackFragmentBaseMediaDecodeTimeBoxView.hh"
+#include "libmedia/mpeg4/box/TrackFragmentHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/TrackFragmentRandomAccessBoxView.hh"
 #include "libmedia/mpeg4/box/TrackHeaderBoxView.hh"
+#include "libmedia/mpeg4/box/TrackRunBoxView.hh"
 
 
 #include "file_view.hh"
@@ -141,8 +162,15 @@ constexpr bool is_full_box(const Mpeg4::BoxHeader &box)
 using BoxCallback_t =
     void (*)(void *data, Mpeg4::BoxView box, size_t offset, size_t level);
 
+/*
+ * skipped_boxes holds content pointers of containers walk_boxes
+ * reports without descending into
+ */
 void walk_boxes(
-    void *user_data, BoxCallback_t cb, std::span<const std::byte> data)
+    void *user_data,
+    BoxCallback_t cb,
+    std::span<const std::byte> data,
+    std::span<const std::byte *const> skipped_boxes = {})
 {
     struct Frame
     {
@@ -197,6 +225,8 @@ void walk_boxes(
             active_box_data = active_box_data.subspan(header.box_content_size.value());
 
             bool go_deeper = is_container_box(header.type) && type_is_printable;
+            go_deeper &= std::ranges::find(skipped_boxes, box_data.data()) ==
+                std::end(skipped_boxes);
             if (go_deeper) {
                 boxes_stack.push({box_data});
                 break;
@@ -225,19 +255,194 @@ void cb(void *data, Mpeg4::BoxView box, size_t offset, size_t level)
         box);
 }
 
+/*
+ * Content pointers of trak boxes not accepted by selection,
+ * their subtrees are skipped without being parsed
+ */
+std::vector<const std::byte *> find_skipped_tracks(
+    std::span<const std::byte> data, const Mpeg4::TrackSelection &selection)
+{
+    std::vector<const std::byte *> output;
+    if (selection.selects_all()) {
+        return output;
+    }
+
+    auto moov = Mpeg4::find_box(data, Mpeg4::TypeTag::from_str("moov"));
+    if (!moov) {
+        return output;
+    }
+
+    auto selected = Mpeg4::select_tracks(moov.value(), selection);
+
+    Mpeg4::BoxSequence moov_children(moov->get_content_data().value());
+    while (auto child = moov_children.next()) {
+        if (child->get_header()->type != Mpeg4::TypeTag::from_str("trak")) {
+            continue;
+        }
+
+        auto content = child->get_content_data()->data();
+        bool is_selected =
+            std::ranges::any_of(selected, [content](auto &track) {
+                return track.trak.get_content_data()->data() == content;
+            });
+        if (!is_selected) {
+            output.push_back(content);
+        }
+    }
+
+    return output;
+}
+
+/*
+ * Prints one line per traf while streaming over fragments, file pages
+ * walked past are released so memory use does not grow with file size
+ */
+int dump_fragments(
+    FileView &f,
+    std::span<const std::byte> data,
+    const Mpeg4::TrackSelection &selection)
+{
+    std::vector<uint32_t> selected_IDs;
+    auto moov = Mpeg4::find_box(data, Mpeg4::TypeTag::from_str("moov"));
+    if (moov) {
+        for (auto &track : Mpeg4::select_tracks(moov.value(), selection)) {
+            selected_IDs.push_back(track.track_ID);
+        }
+    }
+
+    auto is_selected = [&](uint32_t track_ID) {
+        if (!moov) {
+            return selection.accepts_track_ID(track_ID);
+        }
+        return std::ranges::find(selected_IDs, track_ID) !=
+            std::end(selected_IDs);
+    };
+
+    auto print_fragment = [&](const Mpeg4::MovieFragment &fragment) {
+        for (auto &track : fragment.tracks) {
+            if (!is_selected(track.track_ID)) {
+                continue;
+            }
+
+            size_t sync_count = std::ranges::count_if(
+                track.samples, &Mpeg4::FragmentSample::is_sync);
+            std::cout << std::format(
+                "0x{:x} sequence_number {} track_ID {} samples {} sync {} "
+                "duration {}\n",
+                fragment.moof_offset,
+                fragment.sequence_number,
+                track.track_ID,
+                track.samples.size(),
+                sync_count,
+                track.duration);
+        }
+    };
+
+    auto release = [&f](uint64_t offset, uint64_t size) {
+        f.release(offset, size);
+    };
+
+    auto fragment_count =
+        Mpeg4::stream_fragments(data, print_fragment, release);
+    if (!fragment_count) {
+        std::cerr << "Fragment parse failue\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+// Duration and bitrate of a fragmented file from its tail
+int dump_duration(std::span<const std::byte> data)
+{
+    auto probe = Mpeg4::FragmentedDuration::probe(data);
+    if (!probe) {
+        std::cerr << "Not a fragmented file\n";
+        return EXIT_FAILURE;
+    }
+
+    constexpr std::array<std::string_view, 3> source_names{
+        "mfra", "tail_scan", "forward_scan"};
+    std::cout << std::format(
+        "source {} fragments {} bytes_read {}\n",
+        source_names[static_cast<size_t>(probe->source)],
+        probe->fragment_count,
+        probe->bytes_read);
+
+    for (auto &track : probe->tracks) {
+        std::cout << std::format(
+            "track_ID {} end_time {} timescale {}\n",
+            track.track_ID,
+            track.end_time,
+            track.timescale.value_or(0));
+    }
+
+    auto duration = probe->get_duration_seconds();
+    if (duration && duration.value() > 0) {
+        std::cout << std::format(
+            "duration {:.3f} s bitrate {:.0f} bit/s\n",
+            duration.value(),
+            data.size() * 8 / duration.value());
+    }
+    return EXIT_SUCCESS;
+}
+
 int main(int argc, char **argv)
 try {
-    if (argc < 2) {
-        std::cerr << "No args!\n";
+    std::optional<std::string_view> file_path;
+    Mpeg4::TrackSelection selection;
+    bool fragments_only = false;
+    bool duration_only = false;
+
+    for (int arg_idx = 1; arg_idx < argc; arg_idx++) {
+        std::string_view arg = argv[arg_idx];
+        bool has_value = arg_idx + 1 < argc;
+
+        if (arg == "--track-id" && has_value) {
+            selection.track_IDs.push_back(std::stoul(argv[++arg_idx]));
+        } else if (arg == "--handler" && has_value) {
+            selection.handler_types.push_back(
+                Mpeg4::TrackSelection::handler_type_from_str(argv[++arg_idx]));
+        } else if (arg == "--language" && has_value) {
+            std::string_view language = argv[++arg_idx];
+            if (language.size() != 3) {
+                std::cerr << "Language must be 3 letters (ISO 639-2/T)\n";
+                return EXIT_FAILURE;
+            }
+            selection.languages.push_back(
+                {language[0], language[1], language[2]});
+        } else if (arg == "--fragments") {
+            fragments_only = true;
+        } else if (arg == "--duration") {
+            duration_only = true;
+        } else {
+            file_path = arg;
+        }
+    }
+
+    if (!file_path) {
+        std::cerr << "Usage: mp4_dump [--track-id ID] [--handler TYPE] "
+                     "[--language LNG] [--fragments] [--duration] FILE|-\n";
         return EXIT_FAILURE;
     }
 
-    FileView f{argv[1]};
+    FileView f = open_file_view(std::string(file_path.value()).c_str());
     auto boxes_data =
         std::span(reinterpret_cast<const std::byte *>(f.data()), f.size());
 
+    if (fragments_only) {
+        f.advise(0, f.size(), FileAdvice::SEQUENTIAL);
+        return dump_fragments(f, boxes_data, selection);
+    }
+    if (duration_only) {
+        // Reads are a few windows at the head and tail
+        f.advise(0, f.size(), FileAdvice::RANDOM);
+        return dump_duration(boxes_data);
+    }
+
+    auto skipped_tracks = find_skipped_tracks(boxes_data, selection);
+
     std::vector<BoxToDumpData> boxes;
-    walk_boxes(&boxes, cb, boxes_data);
+    walk_boxes(&boxes, cb, boxes_data, skipped_tracks);
 
     size_t max_addr_fmtlen = 0;
     for (auto &dump_d : boxes) {
@@ -326,6 +531,12 @@ try {
                 std::back_inserter(output), ",{}", Mpeg4::dump(co64_box));
         }
 
+        auto elst_box = Mpeg4::EditListBoxView(dump_d.box);
+        if (elst_box.is_valid()) {
+            std::format_to(
+                std::back_inserter(output), ",{}", Mpeg4::dump(elst_box));
+        }
+
         auto stsz_box = Mpeg4::SampleSizeBoxView(dump_d.box);
         if (stsz_box.is_valid()) {
             std::format_to(
@@ -338,6 +549,104 @@ try {
                 std::back_inserter(output), ",{}", Mpeg4::dump(stsd_box));
         }
 
+        auto stts_box = Mpeg4::TimeToSampleBoxView(dump_d.box);
+        if (stts_box.is_valid()) {
+            std::format_to(
+                std::back_inserter(output), ",{}", Mpeg4::dump(stts_box));
+        }
+
+        auto stsc_box = Mpeg4::SampleToChunkBoxView(dump_d.box);
+        if (stsc_box.is_valid()) {
+            std::format_to(
+                std::back_inserter(output), ",{}", Mpeg4::dump(stsc_box));
+        }
+
+        auto stss_box = Mpeg4::SyncSampleBoxView(dump_d.box);
+        if (stss_box.is_valid()) {
+            std::format_to(
+                std::back_inserter(output), ",{}", Mpeg4::dump(stss_box));
+        }
+
+        auto sdtp_box = Mpeg4::SampleDependencyTypeBoxView(dump_d.box);
+        if (sdtp_box.is_valid()) {
+            std::format_to(
+                std::back_inserter(output), ",{}", Mpeg4::dump(sdtp_box));
+        }
+
+        auto sbgp_box = Mpeg4::SampleToGroupBoxView(dump_d.box);
+        if (sbgp_box.is_valid()) {
+            std::format_to(
+                std::back_inserter(output), ",{}", Mpeg4::dump(sbgp_box));
+        }
+
+        auto sgpd_box = Mpeg4::SampleGroupDescriptionBoxView(dump_d.box);
+        if (sgpd_box.is_valid()) {
+            std::format_to(
+                std::back_inserter(output), ",{}", Mpeg4::dump(sgpd_box));
+        }
+
+        auto mfhd_box = Mpeg4::MovieFragmentHeaderBoxView(dump_d.box);
+        if (mfhd_box.is_valid()) {
+            std::format_to(
+                std::back_inserter(output), ",{}", Mpeg4::dump(mfhd_box));
+        }
+
+        auto tfhd_box = Mpeg4::TrackFragmentHeaderBoxView(dump_d.box);
+        if (tfhd_box.is_valid()) {
+            std::format_to(
+                std::back_inserter(output), ",{}", Mpeg4::dump(tfhd_box));
+        }
+
+        auto tfdt_box =
+            Mpeg4::TrackFragmentBaseMediaDecodeTimeBoxView(dump_d.box);
+        if (tfdt_box.is_valid()) {
+            std::format_to(
+                std::back_inserter(output), ",{}", Mpeg4::dump(tfdt_box));
+        }
+
+        auto trun_box = Mpeg4::TrackRunBoxView(dump_d.box);
+        if (trun_box.is_valid()) {
+            std::format_to(
+                std::back_inserter(output), ",{}", Mpeg4::dump(trun_box));
+        }
+
+        auto sidx_box = Mpeg4::SegmentIndexBoxView(dump_d.box);
+        if (sidx_box.is_valid()) {
+            std::format_to(
+                std::back_inserter(output), ",{}", Mpeg4::dump(sidx_box));
+        }
+
+        auto mfra_box = Mpeg4::MovieFragmentRandomAccessBoxView(dump_d.box);
+        if (mfra_box.is_valid()) {
+            std::format_to(
+                std::back_inserter(output), ",{}", Mpeg4::dump(mfra_box));
+        }
+
+        auto mfro_box =
+            Mpeg4::MovieFragmentRandomAccessOffsetBoxView(dump_d.box);
+        if (mfro_box.is_valid()) {
+            std::format_to(
+                std::back_inserter(output), ",{}", Mpeg4::dump(mfro_box));
+        }
+
+        auto tfra_box = Mpeg4::TrackFragmentRandomAccessBoxView(dump_d.box);
+        if (tfra_box.is_valid()) {
+            std::format_to(
+                std::back_inserter(output), ",{}", Mpeg4::dump(tfra_box));
+        }
+
+        auto mehd_box = Mpeg4::MovieExtendsHeaderBoxView(dump_d.box);
+        if (mehd_box.is_valid()) {
+            std::format_to(
+                std::back_inserter(output), ",{}", Mpeg4::dump(mehd_box));
+        }
+
+        auto trex_box = Mpeg4::TrackExtendsBoxView(dump_d.box);
+        if (trex_box.is_valid()) {
+            std::format_to(
+                std::back_inserter(output), ",{}", Mpeg4::dump(trex_box));
+        }
+
         output.append("\n");
     }
 
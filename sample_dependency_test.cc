@@ -0,0 +1,51 @@
+#include <cstddef>
+#include <cstdint>
+
+#include "libmedia/mpeg4/box/SampleDependencyTypeBoxView.hh"
+#include "libmedia/mpeg4/trick_play.hh"
+
+#include "box_test_util.hh"
+
+using Mpeg4::SampleDependencies;
+using Mpeg4::SampleDependencyTypeBoxView;
+
+/*
+ * 10 samples: I picture, then P pictures with every third one
+ * disposable, last byte sets every field
+ */
+constexpr auto test_sdtp_data = as_bytes({
+    0, 0, 0, 22, 's', 'd', 't', 'p', 0, 0, 0, 0, // header, version 0
+    0x20, 0x14, 0x10, 0x18, 0x14, 0x10, 0x18, 0x14, 0x10, 0xe9,
+});
+constexpr SampleDependencyTypeBoxView sdtp(Mpeg4::BoxView{test_sdtp_data});
+
+static_assert(sdtp.is_valid());
+static_assert(sdtp.get_entry_count() == 10);
+static_assert(sdtp.get_entry(0)->sample_depends_on == 2);
+static_assert(sdtp.get_entry(1)->sample_depends_on == 1);
+static_assert(sdtp.get_entry(3)->sample_is_depended_on == 2);
+static_assert(sdtp.get_entry(9)->is_leading == 3);
+static_assert(sdtp.get_entry(9)->sample_depends_on == 2);
+static_assert(sdtp.get_entry(9)->sample_is_depended_on == 2);
+static_assert(sdtp.get_entry(9)->sample_has_redundancy == 1);
+static_assert(!sdtp.get_entry(10).has_value());
+
+consteval bool test_sample_dependencies()
+{
+    auto dependencies = SampleDependencies::decode(sdtp).value();
+    if (dependencies.get_sample_count() != 10) {
+        return false;
+    }
+
+    for (uint32_t sample = 0; sample < 10; sample++) {
+        auto entry = sdtp.get_entry_unsafe(sample);
+        if (dependencies.is_independent(sample) !=
+                (entry.sample_depends_on == 2) ||
+            dependencies.is_disposable(sample) !=
+                (entry.sample_is_depended_on == 2)) {
+            return false;
+        }
+    }
+    return dependencies.is_independent(0) && dependencies.is_disposable(9);
+}
+static_assert(test_sample_dependencies());
@@ -0,0 +1,141 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "libmedia/mpeg4/box/SampleGroupDescriptionBoxView.hh"
+#include "libmedia/mpeg4/box/SampleToGroupBoxView.hh"
+#include "libmedia/mpeg4/sample_groups.hh"
+
+#include "box_test_util.hh"
+
+using Mpeg4::SampleGroupCursor;
+using Mpeg4::SampleGroupDescriptionBoxView;
+using Mpeg4::SampleGroupMap;
+using Mpeg4::SampleToGroupBoxView;
+
+constexpr uint32_t roll_type = 0x726f6c6c; // "roll"
+
+// Samples 0-2 in group 1, empty run, 3-4 in group 1, 5-8 in group 2
+constexpr auto test_sbgp_data = as_bytes({
+    0, 0, 0, 60, 's', 'b', 'g', 'p', 0, 0, 0, 0, // header, version 0
+    'r', 'o', 'l', 'l',                          // grouping_type
+    0, 0, 0, 5,                                  // entry_count
+    0, 0, 0, 3, 0, 0, 0, 1,
+    0, 0, 0, 0, 0, 0, 0, 5,
+    0, 0, 0, 2, 0, 0, 0, 1,
+    0, 0, 0, 4, 0, 0, 0, 2,
+    0, 0, 0, 0, 0, 0, 0, 3,
+});
+constexpr SampleToGroupBoxView sbgp(Mpeg4::BoxView{test_sbgp_data});
+
+static_assert(sbgp.is_valid());
+static_assert(sbgp.get_grouping_type() == roll_type);
+static_assert(!sbgp.get_grouping_type_parameter().has_value());
+static_assert(sbgp.get_entry_count() == 5);
+static_assert(sbgp.get_entry_unsafe(3).sample_count == 4);
+static_assert(sbgp.get_entry_unsafe(3).group_description_index == 2);
+static_assert(!sbgp.get_entry(5).has_value());
+
+constexpr auto test_sbgp_v1_data = as_bytes({
+    0, 0, 0, 32, 's', 'b', 'g', 'p', 1, 0, 0, 0, // header, version 1
+    'r', 'o', 'l', 'l', 0, 0, 0, 9,              // type and parameter
+    0, 0, 0, 1,                                  // entry_count
+    0, 0, 0, 6, 0, 0, 0, 1,
+});
+constexpr SampleToGroupBoxView sbgp_v1(Mpeg4::BoxView{test_sbgp_v1_data});
+
+static_assert(sbgp_v1.is_valid());
+static_assert(sbgp_v1.get_grouping_type_parameter() == 9);
+static_assert(sbgp_v1.get_entry_unsafe(0).sample_count == 6);
+
+// Group of samples 0-10, past the runs samples use default index 7
+constexpr std::array<uint32_t, 11> expected_groups{
+    1, 1, 1, 1, 1, 2, 2, 2, 2, 7, 7};
+
+consteval bool test_sample_group_map()
+{
+    auto map = SampleGroupMap::build(sbgp, 7).value();
+
+    if (map.get_grouping_type() != roll_type || map.get_run_count() != 2 ||
+        map.get_mapped_sample_count() != 9) {
+        return false;
+    }
+    for (uint32_t sample = 0; sample < expected_groups.size(); sample++) {
+        uint32_t index = map.get_group_description_index(sample);
+        if (index != expected_groups[sample]) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(test_sample_group_map());
+
+consteval bool test_sample_group_cursor()
+{
+    SampleGroupCursor cursor(sbgp, 7);
+
+    for (uint32_t sample = 0; sample < expected_groups.size(); sample++) {
+        if (cursor.get_sample_index() != sample ||
+            cursor.next() != expected_groups[sample]) {
+            return false;
+        }
+    }
+    return true;
+}
+static_assert(test_sample_group_cursor());
+
+// Version 0: 2 entries share 6 bytes of payload
+constexpr auto test_sgpd_v0_data = as_bytes({
+    0, 0, 0, 26, 's', 'g', 'p', 'd', 0, 0, 0, 0, // header, version 0
+    'r', 'o', 'l', 'l',                          // grouping_type
+    0, 0, 0, 2,                                  // entry_count
+    1, 2, 3, 4, 5, 6,
+});
+constexpr SampleGroupDescriptionBoxView sgpd_v0(
+    Mpeg4::BoxView{test_sgpd_v0_data});
+
+static_assert(sgpd_v0.is_valid());
+static_assert(sgpd_v0.get_grouping_type() == roll_type);
+static_assert(!sgpd_v0.get_default_length().has_value());
+static_assert(sgpd_v0.get_entry_count() == 2);
+static_assert(sgpd_v0.get_entry(1)->size() == 3);
+static_assert(sgpd_v0.get_entry(1).value()[0] == std::byte(4));
+static_assert(!sgpd_v0.get_entry(2).has_value());
+
+// Version 1 with default_length 2
+constexpr auto test_sgpd_v1_data = as_bytes({
+    0, 0, 0, 28, 's', 'g', 'p', 'd', 1, 0, 0, 0, // header, version 1
+    'r', 'o', 'l', 'l', 0, 0, 0, 2,              // type and default_length
+    0, 0, 0, 2,                                  // entry_count
+    0xff, 0xfe, 0, 1,
+});
+constexpr SampleGroupDescriptionBoxView sgpd_v1(
+    Mpeg4::BoxView{test_sgpd_v1_data});
+
+static_assert(sgpd_v1.is_valid());
+static_assert(sgpd_v1.get_default_length() == 2);
+static_assert(!sgpd_v1.get_default_group_description_index().has_value());
+static_assert(sgpd_v1.get_entry(1)->size() == 2);
+static_assert(sgpd_v1.get_entry(1).value()[1] == std::byte(1));
+
+// Version 2 with variable length entries and default index 2
+constexpr auto test_sgpd_v2_data = as_bytes({
+    0, 0, 0, 40, 's', 'g', 'p', 'd', 2, 0, 0, 0, // header, version 2
+    'r', 'o', 'l', 'l', 0, 0, 0, 0,              // type and default_length
+    0, 0, 0, 2,                                  // default index
+    0, 0, 0, 2,                                  // entry_count
+    0, 0, 0, 1, 9,                               // 1 byte entry
+    0, 0, 0, 3, 7, 8, 9,                         // 3 byte entry
+});
+constexpr SampleGroupDescriptionBoxView sgpd_v2(
+    Mpeg4::BoxView{test_sgpd_v2_data});
+
+static_assert(sgpd_v2.is_valid());
+static_assert(sgpd_v2.get_default_length() == 0);
+static_assert(sgpd_v2.get_default_group_description_index() == 2);
+static_assert(sgpd_v2.get_entry(0)->size() == 1);
+static_assert(sgpd_v2.get_entry(0).value()[0] == std::byte(9));
+static_assert(sgpd_v2.get_entry(1)->size() == 3);
+static_assert(sgpd_v2.get_entry(1).value()[2] == std::byte(9));
+static_assert(!sgpd_v2.get_entry(2).has_value());
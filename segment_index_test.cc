@@ -0,0 +1,65 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "libmedia/mpeg4/box/SegmentIndexBoxView.hh"
+
+#include "box_test_util.hh"
+
+using Mpeg4::SegmentIndexBoxView;
+
+constexpr std::vector<std::byte> make_sidx(uint8_t version)
+{
+    TestPayload payload;
+    payload.u32(1).u32(1000); // reference_ID, timescale
+    if (version == 0) {
+        payload.u32(0x10).u32(0x20);
+    } else {
+        payload.u64(0x100000010).u64(0x100000020);
+    }
+    payload.u16(0).u16(2); // reserved, reference_count
+
+    // sidx reference, 1 MiB, starts with SAP of type 3
+    payload.u32(0x80100000).u32(500).u32(0xb0000007);
+    // Media reference of the largest size, no SAP
+    payload.u32(0x7fffffff).u32(1000).u32(0x0fffffff);
+    return make_full_box("sidx", version, 0, payload);
+}
+
+constexpr bool test_sidx(uint8_t version)
+{
+    auto data = make_sidx(version);
+    SegmentIndexBoxView sidx(Mpeg4::BoxView{data});
+
+    uint64_t high = version == 0 ? 0 : 0x100000000;
+    if (!sidx.is_valid() || sidx.get_reference_ID() != 1 ||
+        sidx.get_timescale() != 1000 ||
+        sidx.get_earliest_presentation_time() != high + 0x10 ||
+        sidx.get_first_offset() != high + 0x20 ||
+        sidx.get_reference_count() != 2) {
+        return false;
+    }
+
+    auto first = sidx.get_reference(0).value();
+    auto second = sidx.get_reference(1).value();
+    return first.reference_type && first.referenced_size == 0x100000 &&
+        first.subsegment_duration == 500 && first.starts_with_SAP &&
+        first.SAP_type == 3 && first.SAP_delta_time == 7 &&
+        !second.reference_type && second.referenced_size == 0x7fffffff &&
+        second.subsegment_duration == 1000 && !second.starts_with_SAP &&
+        second.SAP_type == 0 && second.SAP_delta_time == 0x0fffffff &&
+        !sidx.get_reference(2).has_value();
+}
+
+static_assert(test_sidx(0));
+static_assert(test_sidx(1));
+
+// reference_count larger than the references stored
+consteval bool test_sidx_truncated()
+{
+    auto data = make_sidx(0);
+    data.resize(data.size() - 1);
+    data[3] = std::byte(data.size());
+    return SegmentIndexBoxView(Mpeg4::BoxView{data}).is_not_valid();
+}
+static_assert(test_sidx_truncated());
@@ -0,0 +1,47 @@
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "libmedia/varint.hh"
+
+consteval bool varint_roundtrip(uint64_t value, size_t expected_size)
+{
+    std::vector<uint8_t> buffer;
+    write_varint(buffer, value);
+
+    size_t position = 0;
+    uint64_t decoded = read_varint(buffer, position);
+    return decoded == value && position == buffer.size() &&
+        buffer.size() == expected_size;
+}
+
+static_assert(varint_roundtrip(0, 1));
+static_assert(varint_roundtrip(0x7f, 1));
+static_assert(varint_roundtrip(0x80, 2));
+static_assert(varint_roundtrip(0x3fff, 2));
+static_assert(varint_roundtrip(0x4000, 3));
+static_assert(varint_roundtrip(std::numeric_limits<uint64_t>::max(), 10));
+
+static_assert(zigzag_encode(0) == 0);
+static_assert(zigzag_encode(-1) == 1);
+static_assert(zigzag_encode(1) == 2);
+static_assert(zigzag_encode(-2) == 3);
+static_assert(zigzag_decode(zigzag_encode(-123456789)) == -123456789);
+static_assert(
+    zigzag_decode(zigzag_encode(std::numeric_limits<int64_t>::min())) ==
+    std::numeric_limits<int64_t>::min());
+
+consteval bool varint_truncated(uint64_t value)
+{
+    std::vector<uint8_t> buffer;
+    write_varint(buffer, value);
+    buffer.pop_back();
+
+    size_t position = 0;
+    return !try_read_varint(buffer, position).has_value();
+}
+
+static_assert(varint_truncated(0));
+static_assert(varint_truncated(0x80));
+static_assert(varint_truncated(std::numeric_limits<uint64_t>::max()));